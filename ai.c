@@ -0,0 +1,498 @@
+/*
+ * ai.c - Alpha-beta хайлттай компьютер тоглогч
+ */
+#include "csapp.h"
+#include "ai.h"
+#include "pattern.h"
+#include "vcf.h"
+#include "mcts.h"
+#include <stdint.h>
+#include <limits.h>
+#include <time.h>
+
+#define AI_CHECK_NODES 1024     // Хугацааг шалгах давтамж (2-ын зэрэг)
+#define AI_RADIUS 2             // Чулуунаас энэ зайд байгаа нүднүүд л нүүдэл
+#define AI_MATE (AI_WIN - 1000) // Үүнээс их оноо нь хэдэн нүүдлийн дараах ялалт
+#define AI_JITTER 15            // Туслах хайлтын эрэмбэд нэмэх санамсаргүй хэлбэлзэл
+
+// Transposition table-ийн мөрийн төрөл
+#define TT_EXACT 0
+#define TT_LOWER 1              // Оноо ядаж ийм (beta-гаар тасалсан)
+#define TT_UPPER 2              // Оноо хамгийн ихдээ ийм
+
+#define TT_SIZE (1 << AI_TT_BITS)
+// data: оноо 32, гүн 8, төрөл 2, нүд + 1 16 бит
+#define TT_SCORE(d) ((int32_t)(uint32_t)(d))
+#define TT_DEPTH(d) ((int)((d) >> 32 & 0xff))
+#define TT_FLAG(d)  ((int)((d) >> 40 & 3))
+#define TT_CELL(d)  ((int)((d) >> 42 & 0xffff) - 1)
+
+// Олон thread зэрэг бичдэг тул check = key ^ data хадгалж, хагас бичигдсэн
+// мөрийг уншихад key таарахгүй болж хаягдана
+typedef struct {
+    uint64_t check;
+    uint64_t data;
+} TTEntry;
+
+typedef struct {
+    int cell;                   // row * n + col
+    int order;                  // Эрэмбэлэх оноо
+} Cand;
+
+// Нэг хайлтын төлөв
+typedef struct {
+    Board *b;
+    int n;
+    uint64_t hash;              // Тавигдсан чулуунуудын Zobrist hash
+    int eval;                   // pattern_threats(b, 'X')
+    int *stones;                // Тавигдсан нүднүүд, хайлтынх нь сүүлд
+    int *gains;                 // Тэдгээрийн eval-д нэмсэн өөрчлөлт
+    int nstones;
+    uint32_t *mark;             // Нүүдэл үүсгэхэд давхардсан нүдийг алгасах
+    uint32_t stamp;
+    long deadline;
+    const int *abort;           // Гаднаас зогсоох туг (AiGroup.stop)
+    uint32_t jitter;            // Туслах хайлтын санамсаргүй тоо, үндсэнд 0
+    unsigned long nodes;
+    int stop;                   // Хугацаа дууссан эсвэл зогсоосон
+    int root_best;
+} Search;
+
+static uint64_t zobrist[2][MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+static uint64_t zobrist_side;   // O нүүх ээлжтэй
+static uint64_t zobrist_shape[MAX_BOARD_SIZE + 1][MAX_WIN_LENGTH + 1];
+static TTEntry *tt;
+static pthread_once_t ai_once = PTHREAD_ONCE_INIT;
+
+// Ажлын дараалал (sbuf шиг, хязгааргүй)
+static struct {
+    AiJob *head, *tail;
+    sem_t mutex;
+    sem_t items;
+} queue;
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint32_t xorshift32(uint32_t *x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+static void build_tables(void) {
+    uint64_t seed = 0x584f4c6162ULL;
+
+    for (int p = 0; p < 2; p++)
+        for (int i = 0; i < MAX_BOARD_SIZE * MAX_BOARD_SIZE; i++)
+            zobrist[p][i] = splitmix64(&seed);
+    zobrist_side = splitmix64(&seed);
+    // Өөр хэмжээтэй самбарууд нэг хүснэгтийг хуваалцана
+    for (int n = 0; n <= MAX_BOARD_SIZE; n++)
+        for (int w = 0; w <= MAX_WIN_LENGTH; w++)
+            zobrist_shape[n][w] = splitmix64(&seed);
+    tt = Calloc(TT_SIZE, sizeof(TTEntry));
+    pattern_init();
+}
+
+static int tt_probe(uint64_t key, uint64_t *data) {
+    TTEntry *e = &tt[key & (TT_SIZE - 1)];
+    uint64_t d = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+    uint64_t c = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+
+    if ((c ^ d) != key) return 0;
+    *data = d;
+    return 1;
+}
+
+static void tt_store(uint64_t key, int score, int depth, int flag, int cell) {
+    TTEntry *e = &tt[key & (TT_SIZE - 1)];
+    uint64_t data = (uint32_t)score | (uint64_t)depth << 32 | (uint64_t)flag << 40 |
+                    (uint64_t)(cell + 1) << 42;
+
+    __atomic_store_n(&e->check, key ^ data, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->data, data, __ATOMIC_RELAXED);
+}
+
+// Ялалтын оноог үндсээс биш тухайн зангилаанаас хэмжиж хадгална
+static int score_to_tt(int score, int ply) {
+    if (score > AI_MATE) return score + ply;
+    if (score < -AI_MATE) return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply) {
+    if (score > AI_MATE) return score - ply;
+    if (score < -AI_MATE) return score + ply;
+    return score;
+}
+
+static void search_place(Search *s, int cell, char player) {
+    int row = cell / s->n, col = cell % s->n;
+    int gain = pattern_threat_gain(s->b, row, col, player);
+
+    if (player == 'O') gain = -gain;
+    s->eval += gain;
+    s->hash ^= zobrist[player == 'O'][row * MAX_BOARD_SIZE + col];
+    s->gains[s->nstones] = gain;
+    s->stones[s->nstones++] = cell;
+    board_place(s->b, row, col, player);
+}
+
+static void search_undo(Search *s, char player) {
+    int cell = s->stones[--s->nstones];
+    int row = cell / s->n, col = cell % s->n;
+
+    board_undo(s->b, row, col);
+    s->eval -= s->gains[s->nstones];
+    s->hash ^= zobrist[player == 'O'][row * MAX_BOARD_SIZE + col];
+}
+
+/*
+ * Чулуунаас AI_RADIUS дотор байгаа хоосон нүднүүдээс хамгийн ихдээ max-ийг
+ * эрэмбэлж авах. Эрэмбэ: TT-ийн нүүдэл эхэнд, дараа нь тэр нүдэнд өөрөө
+ * тавих болон өрсөлдөгч тавихад гарах үнэлгээний өөрчлөлтийн нийлбэр
+ */
+static int gen_moves(Search *s, char player, int first, Cand *out, int max) {
+    Board *b = s->b;
+    const int n = s->n;
+    char opp = player == 'X' ? 'O' : 'X';
+    int count = 0;
+
+    if (++s->stamp == 0) {
+        memset(s->mark, 0, (size_t)n * n * sizeof(uint32_t));
+        s->stamp = 1;
+    }
+    for (int i = 0; i < s->nstones; i++) {
+        int r0 = s->stones[i] / n, c0 = s->stones[i] % n;
+        int r1 = r0 + AI_RADIUS < n ? r0 + AI_RADIUS : n - 1;
+        int c1 = c0 + AI_RADIUS < n ? c0 + AI_RADIUS : n - 1;
+        for (int r = r0 > AI_RADIUS ? r0 - AI_RADIUS : 0; r <= r1; r++) {
+            for (int c = c0 > AI_RADIUS ? c0 - AI_RADIUS : 0; c <= c1; c++) {
+                int cell = r * n + c;
+                if (s->mark[cell] == s->stamp || b->cells[cell] != ' ') continue;
+                s->mark[cell] = s->stamp;
+
+                int order = cell == first ? INT_MAX :
+                    pattern_threat_gain(b, r, c, player) + pattern_threat_gain(b, r, c, opp);
+                // Туслахууд өөр мод хайхын тулд ойролцоо оноотой нүднүүдийг хольно
+                if (s->jitter && order != INT_MAX) order += xorshift32(&s->jitter) & AI_JITTER;
+                if (count < max) count++;
+                else if (order <= out[count - 1].order) continue;
+                // Оруулах эрэмбэлэлт, хамгийн сул нь сүүлд
+                int j = count - 1;
+                while (j > 0 && out[j - 1].order < order) {
+                    out[j] = out[j - 1];
+                    j--;
+                }
+                out[j].cell = cell;
+                out[j].order = order;
+            }
+        }
+    }
+    return count;
+}
+
+static int negamax(Search *s, int depth, int ply, int alpha, int beta, char player) {
+    char opp = player == 'X' ? 'O' : 'X';
+
+    if ((++s->nodes & (AI_CHECK_NODES - 1)) == 0 &&
+        (now_ms() >= s->deadline || __atomic_load_n(s->abort, __ATOMIC_RELAXED)))
+        s->stop = 1;
+    if (s->stop) return 0;
+    if (depth == 0) return player == 'X' ? s->eval : -s->eval;
+
+    uint64_t key = s->hash ^ (player == 'O' ? zobrist_side : 0), data;
+    int first = -1;
+    if (tt_probe(key, &data)) {
+        first = TT_CELL(data);
+        if (ply > 0 && TT_DEPTH(data) >= depth) {
+            int score = score_from_tt(TT_SCORE(data), ply), flag = TT_FLAG(data);
+            if (flag == TT_EXACT || (flag == TT_LOWER && score >= beta) ||
+                (flag == TT_UPPER && score <= alpha))
+                return score;
+        }
+    }
+
+    Cand moves[AI_ROOT_BRANCH];
+    int count = gen_moves(s, player, first, moves, ply ? AI_BRANCH : AI_ROOT_BRANCH);
+    if (!count) return 0;
+
+    int alpha0 = alpha, best = -AI_WIN, best_cell = moves[0].cell;
+    for (int i = 0; i < count; i++) {
+        int cell = moves[i].cell, score;
+
+        search_place(s, cell, player);
+        if (board_check_win(s->b, cell / s->n, cell % s->n, player))
+            score = AI_WIN - ply - 1;
+        else if (board_is_full(s->b))
+            score = 0;
+        else
+            score = -negamax(s, depth - 1, ply + 1, -beta, -alpha, opp);
+        search_undo(s, player);
+        if (s->stop) return 0;
+
+        if (score > best) {
+            best = score;
+            best_cell = cell;
+        }
+        if (best > alpha) alpha = best;
+        if (alpha >= beta) break;
+    }
+
+    int flag = best <= alpha0 ? TT_UPPER : best >= beta ? TT_LOWER : TT_EXACT;
+    tt_store(key, score_to_tt(best, ply), depth, flag, best_cell);
+    if (!ply) s->root_best = best_cell;
+    return best;
+}
+
+static void search_init(Search *s, Board *b, const int *abort) {
+    const int n = b->size;
+
+    memset(s, 0, sizeof(*s));
+    s->b = b;
+    s->n = n;
+    s->abort = abort;
+    s->stones = Malloc((size_t)n * n * sizeof(int));
+    s->gains = Malloc((size_t)n * n * sizeof(int));
+    s->mark = Calloc((size_t)n * n, sizeof(uint32_t));
+    s->hash = zobrist_shape[n][b->win_len];
+    for (int cell = 0; cell < n * n; cell++) {
+        char stone = b->cells[cell];
+        if (stone == ' ') continue;
+        s->hash ^= zobrist[stone == 'O'][cell / n * MAX_BOARD_SIZE + cell % n];
+        s->stones[s->nstones++] = cell;
+    }
+    s->eval = pattern_threats(b, 'X');
+}
+
+static void search_free(Search *s) {
+    Free(s->stones);
+    Free(s->gains);
+    Free(s->mark);
+}
+
+// Давталттай гүнзгийрүүлэлт from гүнээс. result-д сүүлийн бүрэн гүний хариу
+static void search_deepen(Search *s, char player, int from, long start, int budget_ms, AiMove *result) {
+    const int n = s->n;
+
+    for (int depth = from; depth <= AI_MAX_DEPTH; depth++) {
+        // Эхний гүнийг хугацаанаас үл хамааран дуусгаж нүүдэлтэй болно
+        s->deadline = depth == 1 ? LONG_MAX : start + budget_ms;
+        s->root_best = -1;
+        int score = negamax(s, depth, 0, -AI_WIN, AI_WIN, player);
+        if (s->stop || s->root_best < 0) break;
+        result->row = s->root_best / n;
+        result->col = s->root_best % n;
+        result->score = score;
+        result->depth = depth;
+        // Ялалт эсвэл ялагдал тодорхой болсон
+        if (score > AI_MATE || score < -AI_MATE) break;
+        if (now_ms() - start >= budget_ms || __atomic_load_n(s->abort, __ATOMIC_RELAXED)) break;
+    }
+}
+
+// Эхлээгүй туслахуудыг дарааллаас хасах. Хассан тоог буцаана
+static int queue_cancel(AiGroup *group) {
+    int removed = 0;
+
+    P(&queue.mutex);
+    AiJob **pp = &queue.head;
+    queue.tail = NULL;
+    while (*pp) {
+        if ((*pp)->group == group) {
+            *pp = (*pp)->next;
+            removed++;
+            continue;
+        }
+        queue.tail = *pp;
+        pp = &(*pp)->next;
+    }
+    V(&queue.mutex);
+    return removed;
+}
+
+void ai_group_start(AiGroup *group, Board *b, char player, int budget_ms, int threads,
+                    void (*help)(AiJob *), void *shared) {
+    const int n = b->size;
+
+    memset(group, 0, sizeof(*group));
+    if (threads > AI_MAX_THREADS) threads = AI_MAX_THREADS;
+    if (threads <= 1) return;
+
+    Sem_init(&group->finished, 0, 0);
+    group->help = help;
+    group->shared = shared;
+    group->count = threads - 1;
+    group->cells = Malloc((size_t)n * n);
+    memcpy(group->cells, b->cells, (size_t)n * n);
+    group->helpers = Calloc(group->count, sizeof(AiJob));
+    for (int i = 0; i < group->count; i++) {
+        AiJob *h = &group->helpers[i];
+        h->size = n;
+        h->win_len = b->win_len;
+        h->cells = group->cells;
+        h->player = player;
+        h->budget_ms = budget_ms;
+        h->group = group;
+        h->helper = i + 1;
+        ai_submit(h);
+    }
+}
+
+void ai_group_finish(AiGroup *group) {
+    __atomic_store_n(&group->stop, 1, __ATOMIC_RELAXED);
+    if (!group->count) return;
+    for (int started = group->count - queue_cancel(group); started > 0; started--)
+        P(&group->finished);
+    Free(group->helpers);
+    Free(group->cells);
+}
+
+void ai_job_board(Board *b, AiJob *job) {
+    int n = job->size;
+
+    board_init(b, BOARD_BITBOARD, n, job->win_len);
+    for (int cell = 0; cell < n * n; cell++)
+        if (job->cells[cell] != ' ')
+            board_place(b, cell / n, cell % n, job->cells[cell]);
+}
+
+// Lazy SMP туслах: үндсэн хайлт зогсох хүртэл TT-г дүүргэнэ. Сондгой
+// туслахууд нэг гүн илүүгээс эхэлж, үндсэн хайлтаас түрүүлж хайна
+static void search_help(AiJob *job) {
+    AiGroup *group = job->group;
+    AiMove m;
+    Board b;
+    Search s;
+
+    ai_job_board(&b, job);
+    search_init(&s, &b, &group->stop);
+    s.jitter = 0x9e3779b9u * job->helper;
+    search_deepen(&s, job->player, 1 + job->helper % 2, now_ms(), job->budget_ms, &m);
+    __atomic_fetch_add(&group->nodes, s.nodes, __ATOMIC_RELAXED);
+    search_free(&s);
+    board_free(&b);
+}
+
+void ai_search(Board *b, char player, int budget_ms, int threads, AiMove *result) {
+    const int n = b->size;
+    long start = now_ms();
+    AiGroup group;
+    Search s;
+
+    Pthread_once(&ai_once, build_tables);
+    result->row = result->col = -1;
+    result->score = 0;
+    result->depth = 0;
+    result->nodes = 0;
+    if (!b->stones) {
+        // Хоосон самбар: төв
+        result->row = result->col = n / 2;
+        result->elapsed_ms = 0;
+        return;
+    }
+    // Дараалсан дөрвөөр ялж чадвал alpha-beta хэрэггүй
+    VcfResult vcf;
+    if (vcf_search(b, player, AI_VCF_NODES, &vcf)) {
+        result->row = vcf.row;
+        result->col = vcf.col;
+        result->score = AI_WIN - 2 * vcf.length + 1;
+        result->nodes = vcf.nodes;
+        result->elapsed_ms = now_ms() - start;
+        return;
+    }
+
+    ai_group_start(&group, b, player, budget_ms, threads, search_help, NULL);
+    search_init(&s, b, &group.stop);
+    search_deepen(&s, player, 1, start, budget_ms, result);
+    search_free(&s);
+    ai_group_finish(&group);
+    result->nodes = s.nodes + group.nodes;
+    result->elapsed_ms = now_ms() - start;
+}
+
+// Самбарын хуулбар дээр хайх. Тоглоомын самбар ямар ч хөдөлгүүртэй байж болно
+static void ai_run(AiJob *job) {
+    const BookEntry *e;
+    Board b;
+
+    if (job->engine == AI_VCF) {
+        ai_job_board(&b, job);
+        vcf_search(&b, job->player, job->playouts, &job->vcf);
+        board_free(&b);
+        return;
+    }
+    if (job->book && book_probe(job->book, job->size, job->win_len, job->cells, job->player,
+                                &job->result.row, &job->result.col, &e)) {
+        job->result.score = e->score;
+        job->result.depth = e->depth;
+        job->result.nodes = 0;
+        job->result.elapsed_ms = 0;
+        job->result.book = 1;
+        return;
+    }
+    job->result.book = 0;
+    ai_job_board(&b, job);
+    if (job->engine == AI_MCTS)
+        mcts_search(&b, job->player, job->budget_ms, job->threads, job->playouts, &job->result);
+    else
+        ai_search(&b, job->player, job->budget_ms, job->threads, &job->result);
+    board_free(&b);
+}
+
+static void *ai_worker(void *vargp) {
+    Pthread_detach(pthread_self());
+    while (1) {
+        P(&queue.items);
+        P(&queue.mutex);
+        AiJob *job = queue.head;
+        if (job) {
+            queue.head = job->next;
+            if (!queue.head) queue.tail = NULL;
+        }
+        V(&queue.mutex);
+
+        // Цуцлагдсан туслахын items тоо үлдэж болно
+        if (!job) continue;
+        if (job->group) {
+            job->group->help(job);
+            V(&job->group->finished);
+            continue;
+        }
+        ai_run(job);
+        job->done(job);
+    }
+    return NULL;
+}
+
+void ai_init(int workers) {
+    pthread_t tid;
+
+    Pthread_once(&ai_once, build_tables);
+    Sem_init(&queue.mutex, 0, 1);
+    Sem_init(&queue.items, 0, 0);
+    for (int i = 0; i < workers; i++)
+        Pthread_create(&tid, NULL, ai_worker, NULL);
+}
+
+void ai_submit(AiJob *job) {
+    job->next = NULL;
+    P(&queue.mutex);
+    if (queue.tail) queue.tail->next = job;
+    else queue.head = job;
+    queue.tail = job;
+    V(&queue.mutex);
+    V(&queue.items);
+}
@@ -0,0 +1,117 @@
+/*
+ * ai.h - Alpha-beta хайлттай компьютер тоглогч
+ *
+ * Negamax alpha-beta, давталттай гүнзгийрүүлэлттэй. Байрлалыг Zobrist
+ * hash-аар түлхүүрлэж, бүх хайлтын хуваалцдаг түгжээгүй transposition
+ * table-д хадгална. Үнэлгээ нь pattern.c-ийн цонхны хүснэгт бөгөөд
+ * хөдөлгөөн бүрт зөвхөн тэр нүдийг хамарсан цонхнуудаар шинэчлэгдэнэ.
+ * Хайлт бүр миллисекундын төсөвтэй: хугацаа дуусвал дуусаагүй гүнийг
+ * хаяж, өмнөх бүрэн гүний хариуг өгнө. Хайлтын өмнө vcf.c-ээр хүчит
+ * ялалт хайж, олдвол шууд тоглоно.
+ *
+ * Олон thread-тэй хайлт нь Lazy SMP: туслах thread-үүд ижил үндсийг өөр
+ * гүнээс, бага зэрэг өөр эрэмбээр хайж, зөвхөн transposition table-ээр
+ * дамжуулан үндсэн хайлтад тусална. Хариуг үндсэн thread л өгнө.
+ */
+#ifndef __AI_H__
+#define __AI_H__
+
+#include "board.h"
+#include "book.h"
+#include "vcf.h"
+#include <semaphore.h>
+
+#define AI_MAX_DEPTH 16
+#define AI_BRANCH 12            // Дотоод зангилаанд шалгах хөдөлгөөн
+#define AI_ROOT_BRANCH 24       // Үндсэнд шалгах хөдөлгөөн
+#define AI_TT_BITS 20           // Transposition table 2^20 мөр, 16 MB
+#define AI_WIN (1 << 28)        // Ялалтын оноо, хэдэн нүүдлийн дараа ялахыг хасна
+#define AI_MAX_THREADS 64       // Нэг хайлтын дээд thread
+#define AI_VCF_NODES 20000      // Хайлтын өмнөх VCF шалгалтын төсөв
+
+typedef struct {
+    int row, col;               // -1 = тавих нүдгүй
+    int score;                  // Хайлт хийсэн тоглогчийн талаас
+    int depth;                  // Бүрэн дууссан гүн
+    unsigned long nodes;        // Бүх thread-ийн нийт
+    long elapsed_ms;
+    int book;                   // Нээлтийн номноос, хайлтгүй
+} AiMove;
+
+typedef enum {
+    AI_ALPHABETA,
+    AI_MCTS,                    // mcts.c
+    AI_VCF                      // Зөвхөн vcf_search, тоглогчийн зөвлөгөөнд
+} AiEngine;
+
+typedef struct AiGroup AiGroup;
+
+// Ажилчин thread-д өгөх хайлт. Дуусахад done-г ажилчин thread дээр дуудна
+typedef struct AiJob {
+    int size, win_len;
+    char *cells;                // size x size, board_snapshot-ийн хэлбэрээр
+    char player;
+    int budget_ms;
+    int threads;                // Хайлтад оролцох thread, үндсэнийг оролцуулаад
+    AiEngine engine;
+    int playouts;               // AI_MCTS: нэг нүүдлийн playout, 0 = хугацаагаар. AI_VCF: зангилааны төсөв
+    const Book *book;           // Байвал эхлээд номноос хайна
+    AiMove result;
+    VcfResult vcf;              // AI_VCF-ийн хариу, result-ийг ашиглахгүй
+    void (*done)(struct AiJob *job);
+    void *arg;
+    struct AiJob *next;
+    AiGroup *group;             // ai.c-ийн дотоод: туслах хайлт бол NULL биш
+    int helper;
+} AiJob;
+
+/*
+ * Нэг олон thread-тэй хайлтын туслахууд, үндсэн thread-ийн стек дээр.
+ * Туслах бүр help-ийг дуудаж, stop болтол shared төлөвт тусална
+ */
+struct AiGroup {
+    int stop;                   // Үндсэн хайлт дууссан
+    unsigned long nodes;        // Туслахуудын зангилаа
+    sem_t finished;             // Эхэлсэн туслах бүр дуусахдаа V хийнэ
+    void (*help)(AiJob *job);
+    void *shared;
+    AiJob *helpers;
+    int count;
+    char *cells;                // Туслахуудын эхлэх самбар
+};
+
+/*
+ * ai_group_start - threads - 1 туслахыг ажилчдын дараалалд өгөх. b-г
+ *     хуулж авах тул дараа нь үндсэн хайлт b-г өөрчилж болно
+ */
+void ai_group_start(AiGroup *group, Board *b, char player, int budget_ms, int threads,
+                    void (*help)(AiJob *), void *shared);
+
+/*
+ * ai_group_finish - Туслахуудыг зогсоох: эхлээгүйг нь дарааллаас хасаж,
+ *     эхэлснийг нь дуустал хүлээнэ
+ */
+void ai_group_finish(AiGroup *group);
+
+// Туслахын самбарыг job->cells-ээс BOARD_BITBOARD-оор үүсгэх
+void ai_job_board(Board *b, AiJob *job);
+
+/*
+ * ai_init - Хүснэгтүүдийг бэлдэж, workers ажилчин thread эхлүүлнэ
+ */
+void ai_init(int workers);
+
+/*
+ * ai_search - b дээр player-ийн хамгийн сайн нүүдлийг budget_ms дотор хайх.
+ *     b нь BOARD_BITBOARD байх ёстой, хайлтын дараа анхны төлөвтөө буцна.
+ *     threads > 1 бол threads - 1 туслахыг ажилчдын дараалалд өгнө; сул
+ *     ажилчин байхгүй бол тэд эхлэхээсээ өмнө цуцлагдана
+ */
+void ai_search(Board *b, char player, int budget_ms, int threads, AiMove *result);
+
+/*
+ * ai_submit - Хайлтыг ажилчин thread-ийн дараалалд оруулах
+ */
+void ai_submit(AiJob *job);
+
+#endif /* __AI_H__ */
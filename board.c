@@ -0,0 +1,476 @@
+/*
+ * board.c - XO самбар болон түүн дээрх шалгалтууд
+ */
+#include "csapp.h"
+#include "board.h"
+#include "pattern.h"
+
+// 5 дараалсан ялах загварууд. analyze_position эндээс зөвхөн чиглэлийг авна
+const Pattern WIN_PATTERNS[] = {
+    // Хэвтээ
+    {{{0,0}, {0,1}, {0,2}, {0,3}, {0,4}}, 100},
+    // Босоо
+    {{{0,0}, {1,0}, {2,0}, {3,0}, {4,0}}, 100},
+    // Диагональ (дээд зүүнээс доод баруун руу)
+    {{{0,0}, {1,1}, {2,2}, {3,3}, {4,4}}, 100},
+    // Диагональ (дээд баруунаас доод зүүн рүү)
+    {{{0,0}, {1,-1}, {2,-2}, {3,-3}, {4,-4}}, 100}
+};
+
+const int WIN_PATTERN_COUNT = sizeof(WIN_PATTERNS)/sizeof(Pattern);
+
+// Загвар таних. Өмнө нь check_win-ий дараа WIN_PATTERNS-ийг 5x5 эхлэлийн цэг
+// бүрээр дахин шалгадаг байсан. Тоглолтын явцад самбар дээр 5 дараалсан
+// байхгүй тул тэр шалгалт check_win-ий олоогүйг олж чадахгүй, дэмий 500 хүртэл
+// нүд уншдаг байв. WIN_PATTERNS одоо зөвхөн оноо тооцоход (analyze_position)
+int check_win_enhanced(int n, char board[][n], int row, int col, char player, int win_len) {
+    return check_win(n, board, row, col, player, win_len);
+}
+
+MoveValidationResult validate_move_enhanced(int n, char board[][n], int row, int col, char *error_msg) {
+    switch(1) {
+        case 1: // Хүрээг шалгах
+            if (row < 0 || row >= n || col < 0 || col >= n) {
+                sprintf(error_msg, "Position (%d,%d) is out of bounds!", row, col);
+                return MOVE_OUT_OF_BOUNDS;
+            }
+            
+        case 2: // Аль хэдийн ашиглаглсан эсэх
+            if (board[row][col] != ' ') {
+                sprintf(error_msg, "Position (%d,%d) is already occupied!", row, col);
+                return MOVE_OCCUPIED;
+            }
+            
+        case 3: // Хүчинтэй
+            return MOVE_VALID;
+            
+        default:
+            return MOVE_INVALID;
+    }
+}
+
+int analyze_position(int n, char board[][n], int row, int col, char player, int win_len) {
+    int score = 0;
+    char opponent = (player == 'X') ? 'O' : 'X';
+    
+    // Бүх загваруудыг шалгах
+    for (int i = 0; i < sizeof(WIN_PATTERNS)/sizeof(Pattern); i++) {
+        int dr = WIN_PATTERNS[i].pattern[1][0], dc = WIN_PATTERNS[i].pattern[1][1];
+        for (int start_row = row - (win_len - 1); start_row <= row; start_row++) {
+            for (int start_col = col - (win_len - 1); start_col <= col; start_col++) {
+                int player_count = 0;
+                int opponent_count = 0;
+                int empty_count = 0;
+                
+                // Загварын чиглэлийн win_len нүдийг тоолох
+                for (int p = 0; p < win_len; p++) {
+                    int check_row = start_row + p * dr;
+                    int check_col = start_col + p * dc;
+                    
+                    if (check_row >= 0 && check_row < n && 
+                        check_col >= 0 && check_col < n) {
+                        if (board[check_row][check_col] == player) {
+                            player_count++;
+                        } else if (board[check_row][check_col] == opponent) {
+                            opponent_count++;
+                        } else if (board[check_row][check_col] == ' ') {
+                            empty_count++;
+                        }
+                    }
+                }
+                
+                // Загварт оноо өгөх
+                if (player_count == win_len) score += 1000;
+                else if (player_count == win_len - 1 && empty_count == 1) score += 100;
+                else if (opponent_count == win_len - 1 && empty_count == 1) score += 50;
+            }
+        }
+    }
+    return score;
+}
+
+int check_win(int n, char board[][n], int row, int col, char player, int win_len) {
+    int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {-1, 1}};
+    for (int d = 0; d < 4; d++) {
+        int dx = directions[d][0];
+        int dy = directions[d][1];
+        int count = 1;
+        int x = row + dx, y = col + dy;
+        while (x >= 0 && x < n && y >= 0 && y < n && board[x][y] == player) {
+            count++;
+            x += dx;
+            y += dy;
+        }
+        x = row - dx;
+        y = col - dy;
+        while (x >= 0 && x < n && y >= 0 && y < n && board[x][y] == player) {
+            count++;
+            x -= dx;
+            y -= dy;
+        }
+        if (count >= win_len) return 1;
+    }
+    return 0;
+}
+
+int validate_move(int n, char board[][n], int row, int col, char *error_msg) {
+    if (row < 0 || row >= n || col < 0 || col >= n) {
+        sprintf(error_msg, "Position (%d,%d) is out of bounds!", row, col);
+        return 0;
+    }
+    if (board[row][col] != ' ') {
+        sprintf(error_msg, "Position (%d,%d) is already occupied!", row, col);
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Самбарын хэмжээнээс хамаарах хүснэгтүүд нэг блокт байрлана
+ */
+#define CELL(b, r, c) ((b)->cells[(r) * (b)->size + (c)])
+#define RUN(arr, b, r, c, d) ((arr)[((r) * (b)->size + (c)) * 4 + (d)])
+
+/*
+ * Шугам бүрийн дараалсан чулууны урт (BOARD_DENSE-ийн ялалт шалгалт)
+ *
+ * Дараалал бүрийн зөвхөн хоёр төгсгөлийн нүдэнд бүтэн уртыг хадгална.
+ * Хоосон нүдний өмнөх хөрш нь дарааллынхаа төгсгөл, дараагийн хөрш нь
+ * эхлэл байх тул шинэ чулуу тавихад хоёр хөршийг л уншиж, хоёр төгсгөлийг
+ * шинэчлэхэд хангалттай: O(1).
+ */
+static const int RUN_DIRS[4][2] = {{0, 1}, {1, 0}, {1, 1}, {-1, 1}};
+
+static int on_board(Board *b, int row, int col) {
+    return row >= 0 && row < b->size && col >= 0 && col < b->size;
+}
+
+// (row, col) нүдний d чиглэлийн өмнөх ба дараах дарааллын урт
+static void run_neighbours(Board *b, int row, int col, int d, char player, int *before, int *after) {
+    int dr = RUN_DIRS[d][0], dc = RUN_DIRS[d][1];
+    int pr = row - dr, pc = col - dc, nr = row + dr, nc = col + dc;
+
+    *before = on_board(b, pr, pc) && CELL(b, pr, pc) == player ? RUN(b->run_end, b, pr, pc, d) : 0;
+    *after = on_board(b, nr, nc) && CELL(b, nr, nc) == player ? RUN(b->run_start, b, nr, nc, d) : 0;
+}
+
+// Чулуу тавьж дарааллуудыг нэгтгээд хамгийн урт дарааллыг буцаах
+static int runs_place(Board *b, int row, int col, char player) {
+    int longest = 0;
+
+    for (int d = 0; d < 4; d++) {
+        int before, after;
+        run_neighbours(b, row, col, d, player, &before, &after);
+        int total = before + 1 + after;
+        RUN(b->run_start, b, row - before * RUN_DIRS[d][0], col - before * RUN_DIRS[d][1], d) = total;
+        RUN(b->run_end, b, row + after * RUN_DIRS[d][0], col + after * RUN_DIRS[d][1], d) = total;
+        if (total > longest) longest = total;
+    }
+    return longest;
+}
+
+// Хоосон нүдэнд player тавибал үүсэх хамгийн урт дараалал
+static int runs_probe(Board *b, int row, int col, char player) {
+    int longest = 0;
+
+    for (int d = 0; d < 4; d++) {
+        int before, after;
+        run_neighbours(b, row, col, d, player, &before, &after);
+        if (before + 1 + after > longest) longest = before + 1 + after;
+    }
+    return longest;
+}
+
+// Дундах нүдний урт хадгалагддаггүй тул шууд тоолно
+static int runs_count(Board *b, int row, int col, char player) {
+    int longest = 0;
+
+    for (int d = 0; d < 4; d++) {
+        int count = 1;
+        for (int s = -1; s <= 1; s += 2) {
+            int x = row + s * RUN_DIRS[d][0], y = col + s * RUN_DIRS[d][1];
+            while (on_board(b, x, y) && CELL(b, x, y) == player) {
+                count++;
+                x += s * RUN_DIRS[d][0];
+                y += s * RUN_DIRS[d][1];
+            }
+        }
+        if (count > longest) longest = count;
+    }
+    return longest;
+}
+
+static int runs_check_win(Board *b, int row, int col, char player) {
+    if (CELL(b, row, col) == ' ')
+        return runs_probe(b, row, col, player) >= b->win_len;
+    // Сүүлд тавьсан чулууны уртыг board_place аль хэдийн тооцсон
+    if (row == b->last_row && col == b->last_col && player == CELL(b, row, col))
+        return b->last_run >= b->win_len;
+    return runs_count(b, row, col, player) >= b->win_len;
+}
+
+/*
+ * Bitboard хөдөлгүүр
+ */
+
+// Шугамын start битээс эхлэх n (<= 57) битийг авах. Үгийн хил дамнаж болно
+uint64_t line_bits(const uint64_t *line, int start, int n) {
+    int i = start >> 6, sh = start & 63;
+    uint64_t x = line[i] >> sh;
+
+    if (sh + n > 64) x |= line[i + 1] << (64 - sh);
+    return x & ((1ULL << n) - 1);
+}
+
+static void line_set(uint64_t *line, int bit) {
+    line[bit >> 6] |= 1ULL << (bit & 63);
+}
+
+// Шугамд p битийг дайрсан win_len дараалсан бит байгаа эсэх
+static int line_has_run(const uint64_t *line, int len, int p, int win_len) {
+    int lo = p - (win_len - 1) < 0 ? 0 : p - (win_len - 1);
+    int hi = p + (win_len - 1) >= len ? len - 1 : p + (win_len - 1);
+    if (hi - lo + 1 < win_len) return 0;
+
+    // p-г тоглогчийнх гэж үзээд, run-ийн i бит нь x-ийн i..i+win_len-1 бүгд 1 үед 1
+    uint64_t x = line_bits(line, lo, hi - lo + 1) | 1ULL << (p - lo);
+    uint64_t run = x;
+    for (int k = 1; k < win_len; k++)
+        run &= x >> k;
+    return run != 0;
+}
+
+static int bitboard_check_win(Board *b, int row, int col, char player) {
+    BitPlane *bp = &b->bits[player == 'O'];
+    int n = b->size, w = b->words;
+    int d = row - col + n - 1, a = row + col;
+
+    // check_win шиг (row, col) нүдийг тоглогчийнх гэж үзнэ
+    return line_has_run(bp->rows + row * w, n, col, b->win_len) ||
+           line_has_run(bp->cols + col * w, n, row, b->win_len) ||
+           line_has_run(bp->diags + d * w, n, row, b->win_len) ||
+           line_has_run(bp->antis + a * w, n, row, b->win_len);
+}
+
+/*
+ * Sparse хөдөлгүүр
+ */
+
+static int sparse_on_board(Board *b, int row, int col) {
+    if (b->size) return on_board(b, row, col);
+    return row >= -SPARSE_LIMIT && row < SPARSE_LIMIT && col >= -SPARSE_LIMIT && col < SPARSE_LIMIT;
+}
+
+// Чиглэл бүрд win_len - 1 хүртэл хөрш нүдийг л хайна
+static int sparse_check_win(Board *b, int row, int col, char player) {
+    for (int d = 0; d < 4; d++) {
+        int count = 1;
+        for (int s = -1; s <= 1; s += 2) {
+            int dr = s * RUN_DIRS[d][0], dc = s * RUN_DIRS[d][1];
+            int x = row + dr, y = col + dc;
+            for (int i = 1; i < b->win_len && sparse_on_board(b, x, y) &&
+                            sparse_get(&b->sparse, x, y) == player; i++) {
+                count++;
+                x += dr;
+                y += dc;
+            }
+        }
+        if (count >= b->win_len) return 1;
+    }
+    return 0;
+}
+
+// analyze_position-ийн цонхнууд r = win_len - 1 үед мөр row-r..row+r, багана
+// col-2r..col+r-д л хүрдэг тул тэр хэсгийг хуулж анхны функцээр тооцно.
+// Самбараас гадуурх нүд '#' тул аль ч тоололд орохгүй
+static int sparse_analyze_position(Board *b, int row, int col, char player) {
+    int r = b->win_len - 1, n = 3 * r + 1;
+    char cells[(3 * MAX_WIN_LENGTH) * (3 * MAX_WIN_LENGTH)];
+    char (*window)[n] = (char (*)[n])cells;
+
+    memset(cells, '#', (size_t)n * n);
+    for (int i = 0; i <= 2 * r; i++)
+        for (int j = 0; j < n; j++) {
+            int wr = row - r + i, wc = col - 2 * r + j;
+            if (sparse_on_board(b, wr, wc)) window[i][j] = sparse_get(&b->sparse, wr, wc);
+        }
+    return analyze_position(n, window, r, 2 * r, player, b->win_len);
+}
+
+/*
+ * board_init - size x size самбарыг бэлдэх. Бүх хүснэгт самбарын
+ *     хэмжээгээр нэг блокт хуваарилагдах тул жижиг самбарын тоглоом
+ *     том самбарын санах ой эзэлдэггүй.
+ */
+void board_init(Board *b, BoardEngine engine, int size, int win_len) {
+    int words = (size + 63) / 64;
+    size_t cells = (size_t)size * size;
+    size_t line_words = (size_t)(2 * size + 2 * (2 * size - 1)) * words;
+
+    memset(b, 0, sizeof(*b));
+    b->engine = engine;
+    b->size = size;
+    b->win_len = win_len;
+    b->words = words;
+    b->last_row = b->last_col = -1;
+
+    if (engine == BOARD_SPARSE) {
+        sparse_init(&b->sparse);
+        return;
+    }
+    b->mem = Calloc(1, 2 * line_words * sizeof(uint64_t) + cells + 2 * cells * 4);
+    uint64_t *w = b->mem;
+    for (int i = 0; i < 2; i++) {
+        b->bits[i].rows = w;
+        b->bits[i].cols = w += size * words;
+        b->bits[i].diags = w += size * words;
+        b->bits[i].antis = w += (2 * size - 1) * words;
+        w += (2 * size - 1) * words;
+    }
+    b->cells = (char *)w;
+    b->run_start = (uint8_t *)b->cells + cells;
+    b->run_end = b->run_start + cells * 4;
+    memset(b->cells, ' ', cells);
+}
+
+void board_free(Board *b) {
+    if (b->engine == BOARD_SPARSE)
+        sparse_free(&b->sparse);
+    Free(b->mem);
+    b->mem = NULL;
+}
+
+void board_place(Board *b, int row, int col, char player) {
+    BitPlane *bp = &b->bits[player == 'O'];
+    int n = b->size, w = b->words;
+
+    b->stones++;
+    b->last_row = row;
+    b->last_col = col;
+    if (b->engine == BOARD_SPARSE) {
+        sparse_put(&b->sparse, row, col, player);
+        return;
+    }
+    line_set(bp->rows + row * w, col);
+    line_set(bp->cols + col * w, row);
+    line_set(bp->diags + (row - col + n - 1) * w, row);
+    line_set(bp->antis + (row + col) * w, row);
+
+    // Дарааллын уртыг зөвхөн BOARD_DENSE ашиглана
+    if (b->engine == BOARD_DENSE)
+        b->last_run = runs_place(b, row, col, player);
+    CELL(b, row, col) = player;
+}
+
+static void line_clear(uint64_t *line, int bit) {
+    line[bit >> 6] &= ~(1ULL << (bit & 63));
+}
+
+/*
+ * board_undo - (row, col)-ийн чулууг авах (AI хайлт). Зөвхөн BOARD_BITBOARD,
+ *     бусад хөдөлгүүрийн дарааллын урт, hash-ийг буцаадаггүй
+ */
+void board_undo(Board *b, int row, int col) {
+    BitPlane *bp = &b->bits[CELL(b, row, col) == 'O'];
+    int n = b->size, w = b->words;
+
+    b->stones--;
+    line_clear(bp->rows + row * w, col);
+    line_clear(bp->cols + col * w, row);
+    line_clear(bp->diags + (row - col + n - 1) * w, row);
+    line_clear(bp->antis + (row + col) * w, row);
+    CELL(b, row, col) = ' ';
+}
+
+char board_get(Board *b, int row, int col) {
+    if (b->engine == BOARD_SPARSE)
+        return sparse_get(&b->sparse, row, col);
+    return CELL(b, row, col);
+}
+
+// size x size тэмдэгт массив болгон хуулах (size > 0)
+void board_snapshot(Board *b, char *cells) {
+    if (b->engine != BOARD_SPARSE) {
+        memcpy(cells, b->cells, (size_t)b->size * b->size);
+        return;
+    }
+    memset(cells, ' ', (size_t)b->size * b->size);
+    for (int i = sparse_next(&b->sparse, 0); i >= 0; i = sparse_next(&b->sparse, i + 1)) {
+        SparseCell *s = &b->sparse.slots[i];
+        cells[s->row * b->size + s->col] = s->stone;
+    }
+}
+
+int board_check_win(Board *b, int row, int col, char player) {
+    if (b->engine == BOARD_BITBOARD)
+        return bitboard_check_win(b, row, col, player);
+    if (b->engine == BOARD_SPARSE)
+        return sparse_check_win(b, row, col, player);
+    return runs_check_win(b, row, col, player);
+}
+
+MoveValidationResult board_validate_move(Board *b, int row, int col, char *error_msg) {
+    if (b->engine == BOARD_DENSE)
+        return validate_move_enhanced(b->size, BOARD_CELLS(b), row, col, error_msg);
+    if (b->engine == BOARD_SPARSE) {
+        if (!sparse_on_board(b, row, col)) {
+            sprintf(error_msg, "Position (%d,%d) is out of bounds!", row, col);
+            return MOVE_OUT_OF_BOUNDS;
+        }
+        if (sparse_get(&b->sparse, row, col) != ' ') {
+            sprintf(error_msg, "Position (%d,%d) is already occupied!", row, col);
+            return MOVE_OCCUPIED;
+        }
+        return MOVE_VALID;
+    }
+
+    if (row < 0 || row >= b->size || col < 0 || col >= b->size) {
+        sprintf(error_msg, "Position (%d,%d) is out of bounds!", row, col);
+        return MOVE_OUT_OF_BOUNDS;
+    }
+    uint64_t occupied = line_bits(b->bits[0].rows + row * b->words, col, 1) |
+                        line_bits(b->bits[1].rows + row * b->words, col, 1);
+    if (occupied) {
+        sprintf(error_msg, "Position (%d,%d) is already occupied!", row, col);
+        return MOVE_OCCUPIED;
+    }
+    return MOVE_VALID;
+}
+
+int board_is_full(Board *b) {
+    if (b->engine == BOARD_SPARSE)
+        return b->stones >= (b->size ? b->size * b->size : SPARSE_MAX_STONES);
+    if (b->engine == BOARD_BITBOARD) {
+        // Мөр бүрийн үгүүд бүтэн дүүрсэн эсэх
+        for (int i = 0; i < b->size; i++) {
+            const uint64_t *x = b->bits[0].rows + i * b->words, *o = b->bits[1].rows + i * b->words;
+            for (int j = 0; j < b->words; j++) {
+                int bits = b->size - 64 * j < 64 ? b->size - 64 * j : 64;
+                uint64_t full = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+                if ((x[j] | o[j]) != full) return 0;
+            }
+        }
+        return 1;
+    }
+
+    for (int i = 0; i < b->size; i++)
+        for (int j = 0; j < b->size; j++)
+            if (CELL(b, i, j) == ' ') return 0;
+    return 1;
+}
+
+int board_analyze_position(Board *b, int row, int col, char player) {
+    if (b->engine == BOARD_BITBOARD)
+        return pattern_analyze_position(b, row, col, player);
+    if (b->engine == BOARD_SPARSE)
+        return sparse_analyze_position(b, row, col, player);
+    return analyze_position(b->size, BOARD_CELLS(b), row, col, player, b->win_len);
+}
+
+int board_engine_parse(const char *name, BoardEngine *engine) {
+    if (!strcmp(name, "dense")) *engine = BOARD_DENSE;
+    else if (!strcmp(name, "bitboard")) *engine = BOARD_BITBOARD;
+    else if (!strcmp(name, "sparse")) *engine = BOARD_SPARSE;
+    else return -1;
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * board.h - XO самбар болон түүн дээрх шалгалтууд
+ */
+#ifndef __BOARD_H__
+#define __BOARD_H__
+
+#include <stdint.h>
+#include "sparse.h"
+
+#define MIN_BOARD_SIZE 5
+#define MAX_BOARD_SIZE 128     // Бүтэн самбарын фрейм 64KB-д багтах
+#define MIN_WIN_LENGTH 3
+#define MAX_WIN_LENGTH 10
+#define SPARSE_LIMIT (1 << 30)       // Хязгааргүй самбарын координатын хүрээ (+-)
+#define SPARSE_MAX_STONES 4096       // Чулууны жагсаалт нэг фреймд багтах
+
+typedef struct {
+    int pattern[5][2];  // Төвтэй харьцуулсан  координатууд
+    int weight;         // Оноо авах загварын ж
+} Pattern;
+
+extern const Pattern WIN_PATTERNS[];
+extern const int WIN_PATTERN_COUNT;
+
+// хөдөлгөөний хүчинтэй эсэх
+typedef enum {
+    MOVE_VALID,
+    MOVE_OUT_OF_BOUNDS,
+    MOVE_OCCUPIED,
+    MOVE_INVALID
+} MoveValidationResult;
+
+// n x n тэмдэгт массив дээрх анхны шалгалтууд (win_len дараалсан). Хөдөлгүүрүүд
+// эдгээртэй яг ижил хариу өгнө
+int check_win(int n, char board[][n], int row, int col, char player, int win_len);
+int check_win_enhanced(int n, char board[][n], int row, int col, char player, int win_len);
+MoveValidationResult validate_move_enhanced(int n, char board[][n], int row, int col, char *error_msg);
+int validate_move(int n, char board[][n], int row, int col, char *error_msg);
+int analyze_position(int n, char board[][n], int row, int col, char player, int win_len);
+
+/*
+ * Самбарын хөдөлгүүр. Хоёулаа ижил үр дүн өгнө:
+ *   BOARD_DENSE    - тэмдэгт массив дээр шугам бүрийн дараалсан чулууны
+ *                    уртыг чулуу тавих бүрт O(1)-ээр шинэчилж, ялалтыг
+ *                    тэр уртаас шууд шийднэ
+ *   BOARD_BITBOARD - тоглогч бүрийн чулууг мөр, багана, хоёр диагоналиар
+ *                    эргүүлсэн 64 битийн үгүүдэд хадгалж, win_len дараалсныг
+ *                    shift ба AND-аар нэг дор шалгана. Оноог pattern.c-ийн
+ *                    хүснэгтээс авна
+ *   BOARD_SPARSE   - зөвхөн эзлэгдсэн нүднүүдийг hash-д хадгалж, шалгалт
+ *                    бүр хөрш нүднүүдийг л хайна. size 0 бол хязгааргүй
+ *                    самбар: координат +-SPARSE_LIMIT дотор, SPARSE_MAX_STONES
+ *                    чулуу тавигдвал тэнцээ
+ */
+typedef enum {
+    BOARD_DENSE,
+    BOARD_BITBOARD,
+    BOARD_SPARSE
+} BoardEngine;
+
+// Нэг тоглогчийн чулуунууд дөрвөн чиглэлээр. Шугам бүр Board.words үгтэй
+typedef struct {
+    uint64_t *rows;    // rows[r]-ийн c-р бит = (r, c)
+    uint64_t *cols;    // cols[c]-ийн r-р бит = (r, c)
+    uint64_t *diags;   // diags[r - c + N - 1]-ийн r-р бит = (r, c)
+    uint64_t *antis;   // antis[r + c]-ийн r-р бит = (r, c)
+} BitPlane;
+
+typedef struct {
+    BoardEngine engine;
+    int size;                            // size x size, 0 = хязгааргүй (BOARD_SPARSE)
+    int win_len;                         // Ялахад шаардлагатай дараалал
+    int words;                           // Нэг шугамын 64 битийн үгийн тоо
+    char *cells;                         // ' ', 'X', 'O', мөрөөр
+    BitPlane bits[2];                    // 0 = X, 1 = O
+    int stones;                          // Тавигдсан чулууны тоо
+    // Дарааллын эхлэл/төгсгөлийн нүдэнд хадгалсан бүтэн урт, 4 чиглэлээр
+    uint8_t *run_start;
+    uint8_t *run_end;
+    int last_row, last_col;              // Сүүлд тавьсан чулуу
+    int last_run;                        // Түүний үүсгэсэн хамгийн урт дараалал
+    void *mem;                           // Дээрх бүх хүснэгтийн блок
+    SparseMap sparse;                    // BOARD_SPARSE-ийн чулуунууд
+} Board;
+
+#define BOARD_DIAGS(b) (2 * (b)->size - 1)
+// Анхны функцүүдэд дамжуулах n x n массив
+#define BOARD_CELLS(b) ((char (*)[(b)->size])(b)->cells)
+
+void board_init(Board *b, BoardEngine engine, int size, int win_len);
+void board_free(Board *b);
+void board_place(Board *b, int row, int col, char player);
+void board_undo(Board *b, int row, int col);
+char board_get(Board *b, int row, int col);
+void board_snapshot(Board *b, char *cells);
+int board_check_win(Board *b, int row, int col, char player);
+MoveValidationResult board_validate_move(Board *b, int row, int col, char *error_msg);
+int board_is_full(Board *b);
+int board_analyze_position(Board *b, int row, int col, char player);
+int board_engine_parse(const char *name, BoardEngine *engine);
+uint64_t line_bits(const uint64_t *line, int start, int n);
+
+#endif /* __BOARD_H__ */
@@ -0,0 +1,540 @@
+/*
+ * boardbench.c - Самбарын шалгалтуудын микро бенчмарк
+ *
+ * Дүүргэлтийн түвшин бүрт тогтмол seed-ээр BENCH_POSITIONS санамсаргүй
+ * байрлал (эсвэл -J журналын дууссан тоглоомуудын эцсийн байрлал) үүсгэж,
+ * тэдгээр дээрх асуултуудыг кернел бүрээр гүйлгэнэ. Нэг хэмжилт нь
+ * асуултын массивыг BENCH_SAMPLE_NS орчим давтаж, BENCH_REPEATS
+ * хэмжилтийн медианыг ns/call, cycles/call-оор хэвлэнэ. cycles нь TSC
+ * (тогтмол давтамжийн) тоолуур тул турбо үед бодит цикльээс зөрж болно.
+ *
+ * -o файлд үр дүнг хадгалж, -c файлтай харьцуулбал -T хувиас удааширсан
+ * кернелийг тэмдэглээд 1 буцаана. Файлын самбар, seed өөр бол 2.
+ *
+ * -C нь хэмжихгүйгээр ижил асуултуудаар хөдөлгүүр бүрийг анхны n x n
+ * функцүүдтэй тулгаж, зөрүү олдвол 1 буцаана (make check).
+ */
+#include "csapp.h"
+#include "board.h"
+#include "pattern.h"
+#include "journal.h"
+#include "proto.h"
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define read_tsc() __rdtsc()
+#else
+#define read_tsc() 0ULL
+#endif
+
+#define BENCH_POSITIONS 64
+#define BENCH_QUERIES 4096
+#define BENCH_REPEATS 7
+#define BENCH_SAMPLE_NS 20000000L   // Нэг хэмжилтийн доод хугацаа
+#define BENCH_THRESHOLD 10.0        // Харьцуулахад удаашралын хувь
+#define BENCH_MAX_SETS 16
+#define BENCH_MAX_RESULTS 512
+#define ENGINES 3
+
+typedef struct {
+    int pos, row, col;
+    char player;
+} Query;
+
+// Нэг дүүргэлтийн түвшний байрлалууд, асуултууд
+typedef struct {
+    char name[16];
+    int count;
+    char *cells[BENCH_POSITIONS];            // Анхны функцүүдийн n x n массив
+    Board boards[ENGINES][BENCH_POSITIONS];  // Ижил байрлал хөдөлгүүр бүрт
+    Query stone[BENCH_QUERIES];              // Эзэлсэн нүд, түүний тоглогч
+    Query empty[BENCH_QUERIES];              // Хоосон нүд, санамсаргүй тоглогч
+    Query any[BENCH_QUERIES];                // Самбараас гадуурх нүд ч орно
+} Set;
+
+typedef struct {
+    const char *name;
+    int engine;                 // -1 = анхны n x n функц
+    long (*run)(Set *s, int engine);
+} Kernel;
+
+typedef struct {
+    char kernel[48], set[16];
+    double ns, cycles;
+} Result;
+
+static int size = DEFAULT_BOARD_SIZE, win_len = DEFAULT_WIN_LENGTH;
+static unsigned int seed = 12345;
+static const char *engine_names[ENGINES] = {"dense", "bitboard", "sparse"};
+
+static unsigned int next_rand(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+#define CELLS(s, q) ((char (*)[size])(s)->cells[(q)->pos])
+
+/*
+ * Кернелүүд. Асуултын массивыг нэг удаа гүйж, үр дүнгийн нийлбэрийг
+ * буцаана: хөрвүүлэгч дуудлагыг хасаж чадахгүй
+ */
+
+static long run_check_win(Set *s, int engine) {
+    long sum = 0;
+    for (Query *q = s->stone; q < s->stone + BENCH_QUERIES; q++)
+        sum += check_win(size, CELLS(s, q), q->row, q->col, q->player, win_len);
+    return sum;
+}
+
+static long run_check_win_enhanced(Set *s, int engine) {
+    long sum = 0;
+    for (Query *q = s->stone; q < s->stone + BENCH_QUERIES; q++)
+        sum += check_win_enhanced(size, CELLS(s, q), q->row, q->col, q->player, win_len);
+    return sum;
+}
+
+static long run_validate_move(Set *s, int engine) {
+    char error_msg[100];
+    long sum = 0;
+    for (Query *q = s->any; q < s->any + BENCH_QUERIES; q++)
+        sum += validate_move(size, CELLS(s, q), q->row, q->col, error_msg);
+    return sum;
+}
+
+static long run_validate_move_enhanced(Set *s, int engine) {
+    char error_msg[100];
+    long sum = 0;
+    for (Query *q = s->any; q < s->any + BENCH_QUERIES; q++)
+        sum += validate_move_enhanced(size, CELLS(s, q), q->row, q->col, error_msg);
+    return sum;
+}
+
+static long run_analyze_position(Set *s, int engine) {
+    long sum = 0;
+    for (Query *q = s->empty; q < s->empty + BENCH_QUERIES; q++)
+        sum += analyze_position(size, CELLS(s, q), q->row, q->col, q->player, win_len);
+    return sum;
+}
+
+// Анхны серверийн тэнцээний шалгалт: хоосон нүд хайж бүтэн самбарыг гүйнэ
+static long run_draw_scan(Set *s, int engine) {
+    long sum = 0;
+    for (Query *q = s->stone; q < s->stone + BENCH_QUERIES; q++) {
+        char (*board)[size] = CELLS(s, q);
+        int is_draw = 1;
+        for (int i = 0; i < size; i++)
+            for (int j = 0; j < size; j++)
+                if (board[i][j] == ' ') is_draw = 0;
+        sum += is_draw;
+    }
+    return sum;
+}
+
+static long run_board_check_win(Set *s, int engine) {
+    long sum = 0;
+    for (Query *q = s->stone; q < s->stone + BENCH_QUERIES; q++)
+        sum += board_check_win(&s->boards[engine][q->pos], q->row, q->col, q->player);
+    return sum;
+}
+
+static long run_board_validate_move(Set *s, int engine) {
+    char error_msg[100];
+    long sum = 0;
+    for (Query *q = s->any; q < s->any + BENCH_QUERIES; q++)
+        sum += board_validate_move(&s->boards[engine][q->pos], q->row, q->col, error_msg);
+    return sum;
+}
+
+static long run_board_analyze_position(Set *s, int engine) {
+    long sum = 0;
+    for (Query *q = s->empty; q < s->empty + BENCH_QUERIES; q++)
+        sum += board_analyze_position(&s->boards[engine][q->pos], q->row, q->col, q->player);
+    return sum;
+}
+
+static long run_board_is_full(Set *s, int engine) {
+    long sum = 0;
+    for (Query *q = s->stone; q < s->stone + BENCH_QUERIES; q++)
+        sum += board_is_full(&s->boards[engine][q->pos]);
+    return sum;
+}
+
+static const Kernel kernels[] = {
+    {"check_win", -1, run_check_win},
+    {"check_win_enhanced", -1, run_check_win_enhanced},
+    {"validate_move", -1, run_validate_move},
+    {"validate_move_enhanced", -1, run_validate_move_enhanced},
+    {"analyze_position", -1, run_analyze_position},
+    {"draw_scan", -1, run_draw_scan},
+    {"board_check_win", BOARD_DENSE, run_board_check_win},
+    {"board_check_win", BOARD_BITBOARD, run_board_check_win},
+    {"board_check_win", BOARD_SPARSE, run_board_check_win},
+    {"board_validate_move", BOARD_DENSE, run_board_validate_move},
+    {"board_validate_move", BOARD_BITBOARD, run_board_validate_move},
+    {"board_validate_move", BOARD_SPARSE, run_board_validate_move},
+    {"board_analyze_position", BOARD_DENSE, run_board_analyze_position},
+    {"board_analyze_position", BOARD_BITBOARD, run_board_analyze_position},
+    {"board_analyze_position", BOARD_SPARSE, run_board_analyze_position},
+    {"board_is_full", BOARD_DENSE, run_board_is_full},
+    {"board_is_full", BOARD_BITBOARD, run_board_is_full},
+    {"board_is_full", BOARD_SPARSE, run_board_is_full},
+};
+#define KERNEL_COUNT (int)(sizeof(kernels) / sizeof(kernels[0]))
+
+static Set *set_new(const char *name) {
+    Set *s = Calloc(1, sizeof(Set));
+    snprintf(s->name, sizeof(s->name), "%s", name);
+    return s;
+}
+
+// Байрлал нэмэх: cells-ийг хадгалж, хөдөлгүүр бүрт ижил чулуунуудыг тавина
+static void set_add(Set *s, char *cells) {
+    int i = s->count++;
+    s->cells[i] = cells;
+    for (int e = 0; e < ENGINES; e++) {
+        board_init(&s->boards[e][i], e, size, win_len);
+        for (int c = 0; c < size * size; c++)
+            if (cells[c] != ' ') board_place(&s->boards[e][i], c / size, c % size, cells[c]);
+    }
+}
+
+// Асуултуудыг байрлалуудаас тогтмол seed-ээр сонгох
+static void set_queries(Set *s) {
+    int n = size * size;
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        Query *q = &s->stone[i];
+        q->pos = next_rand() % s->count;
+        char *cells = s->cells[q->pos];
+        int c = next_rand() % n, tries = 0;
+        while (cells[c] == ' ' && tries++ < n) c = (c + 1) % n;
+        q->row = c / size;
+        q->col = c % size;
+        q->player = cells[c] == ' ' ? 'X' : cells[c];
+
+        q = &s->empty[i];
+        q->pos = next_rand() % s->count;
+        cells = s->cells[q->pos];
+        c = next_rand() % n, tries = 0;
+        while (cells[c] != ' ' && tries++ < n) c = (c + 1) % n;
+        q->row = c / size;
+        q->col = c % size;
+        q->player = next_rand() & 1 ? 'O' : 'X';
+
+        // 1/16 нь самбараас гадуур
+        q = &s->any[i];
+        q->pos = next_rand() % s->count;
+        q->row = next_rand() % (size + 2) - 1;
+        q->col = next_rand() % (size + 2) - 1;
+        if (next_rand() % 16 == 0) q->row = size;
+        q->player = 'X';
+    }
+}
+
+// fill хувь дүүргэсэн санамсаргүй байрлалууд, X, O ээлжилнэ
+static Set *set_random(int fill) {
+    char name[16];
+    snprintf(name, sizeof(name), "rand%d", fill);
+    Set *s = set_new(name);
+    int n = size * size, stones = n * fill / 100;
+    for (int p = 0; p < BENCH_POSITIONS; p++) {
+        char *cells = Malloc(n);
+        memset(cells, ' ', n);
+        for (int k = 0; k < stones; k++) {
+            int c = next_rand() % n;
+            while (cells[c] != ' ') c = (c + 1) % n;
+            cells[c] = k & 1 ? 'O' : 'X';
+        }
+        set_add(s, cells);
+    }
+    set_queries(s);
+    return s;
+}
+
+/*
+ * set_journal - Журналаас энэ хэмжээтэй хамгийн эхний BENCH_POSITIONS
+ *     тоглоомын хүчинтэй нүүдлүүдийг тавьж, эцсийн байрлалыг авна
+ */
+static Set *set_journal(const char *path) {
+    struct stat st;
+    int fd = Open(path, O_RDONLY, 0);
+    Fstat(fd, &st);
+    if ((size_t)st.st_size < sizeof(JournalHeader))
+        app_error("boardbench: not a game journal");
+    char *map = Mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    Close(fd);
+    const JournalHeader *hdr = (const JournalHeader *)map;
+    if (hdr->magic != JOURNAL_MAGIC || hdr->version != JOURNAL_VERSION || hdr->record_size != sizeof(JournalRecord))
+        app_error("boardbench: not a game journal");
+    const JournalRecord *recs = (const JournalRecord *)(hdr + 1);
+    size_t count = (st.st_size - sizeof(*hdr)) / sizeof(JournalRecord);
+
+    uint64_t ids[BENCH_POSITIONS];
+    char *cells[BENCH_POSITIONS];
+    int games = 0, n = size * size;
+    for (size_t i = 0; i < count; i++) {
+        const JournalRecord *r = &recs[i];
+        if (r->type == JOURNAL_START) {
+            if (games < BENCH_POSITIONS && r->row == size && r->col == win_len) {
+                ids[games] = r->game;
+                cells[games] = Malloc(n);
+                memset(cells[games], ' ', n);
+                games++;
+            }
+            continue;
+        }
+        if (r->type != JOURNAL_MOVE || JOURNAL_RESULT(r->info) != MOVE_VALID) continue;
+        for (int g = 0; g < games; g++)
+            if (ids[g] == r->game) {
+                cells[g][r->row * size + r->col] = JOURNAL_SEAT(r->info) ? 'O' : 'X';
+                break;
+            }
+    }
+    Munmap(map, st.st_size);
+    if (!games) {
+        fprintf(stderr, "boardbench: no %dx%d win %d games in %s\n", size, size, win_len, path);
+        exit(1);
+    }
+
+    Set *s = set_new("journal");
+    for (int g = 0; g < games; g++) set_add(s, cells[g]);
+    set_queries(s);
+    return s;
+}
+
+static void set_free(Set *s) {
+    for (int i = 0; i < s->count; i++) {
+        for (int e = 0; e < ENGINES; e++) board_free(&s->boards[e][i]);
+        Free(s->cells[i]);
+    }
+    Free(s);
+}
+
+/*
+ * verify_set - Асуулт бүрт хөдөлгүүр бүрийн хариуг анхны функцийнхтэй
+ *     тулгах. Bitboard дээр pattern_threat_gain-ийг чулуу тавьж, буцаасан
+ *     pattern_threats-ийн зөрүүтэй тулгана. Зөрүүний тоог буцаана
+ */
+static long verify_set(Set *s, long *checks) {
+    char error_msg[100];
+    long bad = 0;
+    // pattern_threats бүтэн самбарыг гүйх тул том самбарт цөөн асуултаар
+    int threat_stride = size * size / 256 + 1;
+
+#define VERIFY(what, got, want, q) do {                                              \
+        ++*checks;                                                                  \
+        if ((got) != (want) && bad++ < 10)                                          \
+            fprintf(stderr, "boardbench: %s %s pos %d (%d,%d) %c: %d, expected %d\n", \
+                    s->name, what, (q)->pos, (q)->row, (q)->col, (q)->player, got, want); \
+    } while (0)
+
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        Query *q = &s->stone[i];
+        int want = check_win(size, CELLS(s, q), q->row, q->col, q->player, win_len);
+        VERIFY("check_win_enhanced", check_win_enhanced(size, CELLS(s, q), q->row, q->col, q->player, win_len), want, q);
+        for (int e = 0; e < ENGINES; e++)
+            VERIFY(engine_names[e], board_check_win(&s->boards[e][q->pos], q->row, q->col, q->player), want, q);
+
+        q = &s->any[i];
+        want = validate_move_enhanced(size, CELLS(s, q), q->row, q->col, error_msg);
+        VERIFY("validate_move", validate_move(size, CELLS(s, q), q->row, q->col, error_msg), want == MOVE_VALID, q);
+        for (int e = 0; e < ENGINES; e++)
+            VERIFY(engine_names[e], board_validate_move(&s->boards[e][q->pos], q->row, q->col, error_msg), want, q);
+
+        q = &s->empty[i];
+        want = analyze_position(size, CELLS(s, q), q->row, q->col, q->player, win_len);
+        for (int e = 0; e < ENGINES; e++)
+            VERIFY(engine_names[e], board_analyze_position(&s->boards[e][q->pos], q->row, q->col, q->player), want, q);
+
+        Board *b = &s->boards[BOARD_BITBOARD][q->pos];
+        if (i % threat_stride == 0 && board_get(b, q->row, q->col) == ' ') {
+            int before = pattern_threats(b, 'X'), gain = pattern_threat_gain(b, q->row, q->col, q->player);
+            board_place(b, q->row, q->col, q->player);
+            int after = pattern_threats(b, 'X');
+            board_undo(b, q->row, q->col);
+            VERIFY("pattern_threat_gain", gain, q->player == 'X' ? after - before : before - after, q);
+        }
+    }
+    for (int p = 0; p < s->count; p++) {
+        Query q = {p, 0, 0, ' '};
+        int want = !memchr(s->cells[p], ' ', size * size);
+        for (int e = 0; e < ENGINES; e++)
+            VERIFY(engine_names[e], board_is_full(&s->boards[e][p]), want, &q);
+    }
+#undef VERIFY
+    return bad;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+/*
+ * measure - Эхлээд BENCH_SAMPLE_NS-д хүрэх давталтын тоог олоод,
+ *     BENCH_REPEATS хэмжилтийн медианыг нэг дуудлагад хуваана
+ */
+static volatile long sink;
+
+static void measure(const Kernel *k, Set *s, Result *r) {
+    long iters = 1;
+    while (1) {
+        long t0 = now_ns();
+        for (long i = 0; i < iters; i++) sink += k->run(s, k->engine);
+        if (now_ns() - t0 >= BENCH_SAMPLE_NS / 4) break;
+        iters *= 2;
+    }
+    iters *= 4;
+
+    double ns[BENCH_REPEATS], cycles[BENCH_REPEATS], calls = (double)iters * BENCH_QUERIES;
+    for (int rep = 0; rep < BENCH_REPEATS; rep++) {
+        long t0 = now_ns();
+        unsigned long long c0 = read_tsc();
+        for (long i = 0; i < iters; i++) sink += k->run(s, k->engine);
+        cycles[rep] = (read_tsc() - c0) / calls;
+        ns[rep] = (now_ns() - t0) / calls;
+    }
+    qsort(ns, BENCH_REPEATS, sizeof(double), cmp_double);
+    qsort(cycles, BENCH_REPEATS, sizeof(double), cmp_double);
+    r->ns = ns[BENCH_REPEATS / 2];
+    r->cycles = cycles[BENCH_REPEATS / 2];
+}
+
+static void kernel_name(const Kernel *k, char *buf, size_t len) {
+    if (k->engine < 0) snprintf(buf, len, "%s", k->name);
+    else snprintf(buf, len, "%s/%s", k->name, engine_names[k->engine]);
+}
+
+/*
+ * load_baseline - Хадгалсан үр дүн: "# boardbench" толгой, дараа нь
+ *     "kernel set ns cycles" мөрүүд, # коммент. Толгойн самбар, seed энэ
+ *     ажиллуулалтынхаас өөр бол байрлалууд өөр тул харьцуулахаас татгалзана
+ */
+static int load_baseline(const char *path, unsigned int run_seed, Result *base, int max) {
+    FILE *f = fopen(path, "r");
+    if (!f) unix_error("boardbench: baseline");
+    char line[MAXLINE];
+    int count = 0, header = 0;
+    while (count < max && fgets(line, sizeof(line), f)) {
+        int n, n2, w;
+        unsigned int sd;
+        if (sscanf(line, "# boardbench %dx%d win %d seed %u", &n, &n2, &w, &sd) == 4) {
+            header = 1;
+            if (n != size || w != win_len || sd != run_seed) {
+                fprintf(stderr, "boardbench: baseline %s is %dx%d win %d seed %u, this run is %dx%d win %d seed %u\n",
+                        path, n, n, w, sd, size, size, win_len, run_seed);
+                exit(2);
+            }
+            continue;
+        }
+        if (line[0] == '#') continue;
+        Result *r = &base[count];
+        if (sscanf(line, "%47s %15s %lf %lf", r->kernel, r->set, &r->ns, &r->cycles) == 4) count++;
+    }
+    fclose(f);
+    if (!header)
+        fprintf(stderr, "boardbench: warning: baseline %s has no header, board and seed are not checked\n", path);
+    return count;
+}
+
+int main(int argc, char **argv) {
+    int opt, fills[BENCH_MAX_SETS] = {10, 30, 60, 90}, nfills = 4;
+    const char *journal = NULL, *save = NULL, *compare = NULL, *filter = NULL;
+    double threshold = BENCH_THRESHOLD;
+    int verify = 0;
+    // -n, -w: самбар, -f: дүүргэлтийн хувиуд (таслалаар), -J: журналын байрлал,
+    // -k: нэрэнд агуулагдах кернел л, -s: seed, -o: үр дүнг хадгалах,
+    // -c: хадгалсантай харьцуулах, -T: удаашралын босго хувь, -C: тулгалт л
+    while ((opt = getopt(argc, argv, "n:w:f:J:k:s:o:c:T:C")) != -1) {
+        if (opt == 'n') size = atoi(optarg);
+        else if (opt == 'w') win_len = atoi(optarg);
+        else if (opt == 'f') {
+            nfills = 0;
+            for (char *p = strtok(optarg, ","); p && nfills < BENCH_MAX_SETS - 1; p = strtok(NULL, ","))
+                fills[nfills++] = atoi(p);
+        }
+        else if (opt == 'J') journal = optarg;
+        else if (opt == 'k') filter = optarg;
+        else if (opt == 's') seed = strtoul(optarg, NULL, 0) | 1;
+        else if (opt == 'o') save = optarg;
+        else if (opt == 'c') compare = optarg;
+        else if (opt == 'T') threshold = atof(optarg);
+        else if (opt == 'C') verify = 1;
+        else argc = 0;
+    }
+    if (argc != optind || size < MIN_BOARD_SIZE || size > MAX_BOARD_SIZE || win_len < MIN_WIN_LENGTH ||
+        win_len > MAX_WIN_LENGTH || win_len > size) {
+        fprintf(stderr, "Usage: %s [-n size] [-w win_length] [-f fill%%,...] [-J journal] [-k kernel] "
+                "[-s seed] [-o save] [-c baseline [-T pct]] [-C]\n", argv[0]);
+        exit(0);
+    }
+    unsigned int run_seed = seed;   // Байрлал үүсгэхэд seed өөрчлөгдөнө
+    pattern_init();
+
+    Set *sets[BENCH_MAX_SETS];
+    int nsets = 0;
+    for (int i = 0; i < nfills; i++)
+        if (fills[i] >= 0 && fills[i] < 100) sets[nsets++] = set_random(fills[i]);
+    if (journal) sets[nsets++] = set_journal(journal);
+
+    if (verify) {
+        long bad = 0, checks = 0;
+        for (int i = 0; i < nsets; i++) bad += verify_set(sets[i], &checks);
+        printf("%dx%d win %d seed %u: %ld checks, %ld mismatches\n", size, size, win_len, run_seed, checks, bad);
+        for (int i = 0; i < nsets; i++) set_free(sets[i]);
+        return bad != 0;
+    }
+
+    Result *base = NULL;
+    int nbase = 0;
+    if (compare) {
+        base = Malloc(BENCH_MAX_RESULTS * sizeof(Result));
+        nbase = load_baseline(compare, run_seed, base, BENCH_MAX_RESULTS);
+    }
+    FILE *out = NULL;
+    if (save) {
+        out = fopen(save, "w");
+        if (!out) unix_error("boardbench: save");
+        fprintf(out, "# boardbench %dx%d win %d seed %u\n", size, size, win_len, run_seed);
+    }
+
+    printf("%dx%d win %d, %d positions x %d queries per set\n", size, size, win_len, BENCH_POSITIONS, BENCH_QUERIES);
+    printf("%-32s %-8s %10s %12s%s\n", "kernel", "set", "ns/call", "cycles/call", compare ? "   baseline    delta" : "");
+    int regressions = 0;
+    for (int k = 0; k < KERNEL_COUNT; k++) {
+        char name[48];
+        kernel_name(&kernels[k], name, sizeof(name));
+        if (filter && !strstr(name, filter)) continue;
+        for (int i = 0; i < nsets; i++) {
+            Result r;
+            snprintf(r.kernel, sizeof(r.kernel), "%s", name);
+            snprintf(r.set, sizeof(r.set), "%s", sets[i]->name);
+            measure(&kernels[k], sets[i], &r);
+            printf("%-32s %-8s %10.2f %12.1f", r.kernel, r.set, r.ns, r.cycles);
+            if (out) fprintf(out, "%s %s %.3f %.2f\n", r.kernel, r.set, r.ns, r.cycles);
+            for (int b = 0; b < nbase; b++) {
+                if (strcmp(base[b].kernel, r.kernel) || strcmp(base[b].set, r.set)) continue;
+                double delta = (r.ns - base[b].ns) / base[b].ns * 100;
+                int slow = delta > threshold;
+                regressions += slow;
+                printf("   %8.2f  %+6.1f%%%s", base[b].ns, delta, slow ? "  REGRESSION" : "");
+                break;
+            }
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+    if (compare) printf("%d regressions over %.1f%%\n", regressions, threshold);
+
+    if (out) fclose(out);
+    Free(base);
+    for (int i = 0; i < nsets; i++) set_free(sets[i]);
+    return regressions != 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * book.c - Нээлтийн ном
+ */
+#include "csapp.h"
+#include "book.h"
+
+// splitmix64: файлд хадгалагдах тул санамсаргүй биш, тогтмол хэш хэрэгтэй
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// sym: 1 = мөр баганыг солих, 2 = мөрийг тусгах, 4 = баганыг тусгах
+void book_transform(int size, int sym, int row, int col, int *r, int *c) {
+    if (sym & 1) {
+        int t = row;
+        row = col;
+        col = t;
+    }
+    if (sym & 2) row = size - 1 - row;
+    if (sym & 4) col = size - 1 - col;
+    *r = row;
+    *c = col;
+}
+
+void book_untransform(int size, int sym, int row, int col, int *r, int *c) {
+    if (sym & 4) col = size - 1 - col;
+    if (sym & 2) row = size - 1 - row;
+    if (sym & 1) {
+        int t = row;
+        row = col;
+        col = t;
+    }
+    *r = row;
+    *c = col;
+}
+
+uint64_t book_key(int size, int win_len, const char *cells, char player, int *sym) {
+    uint64_t salt = mix64((uint64_t)size << 16 | (uint64_t)win_len << 8 | (player == 'O'));
+    uint64_t h[8] = {0};
+
+    for (int cell = 0; cell < size * size; cell++) {
+        if (cells[cell] == ' ') continue;
+        for (int t = 0; t < 8; t++) {
+            int r, c;
+            book_transform(size, t, cell / size, cell % size, &r, &c);
+            h[t] ^= mix64((uint64_t)(r * size + c) << 1 | (cells[cell] == 'O'));
+        }
+    }
+
+    int best = 0;
+    for (int t = 1; t < 8; t++)
+        if (h[t] < h[best]) best = t;
+    if (sym) *sym = best;
+    return h[best] ^ salt;
+}
+
+int book_open(Book *book, const char *path) {
+    struct stat st;
+    int fd = Open(path, O_RDONLY, 0);
+
+    Fstat(fd, &st);
+    if ((size_t)st.st_size < sizeof(BookHeader)) {
+        Close(fd);
+        return -1;
+    }
+    book->len = st.st_size;
+    book->map = Mmap(NULL, book->len, PROT_READ, MAP_SHARED, fd, 0);
+    Close(fd);
+
+    book->hdr = book->map;
+    book->entries = (const BookEntry *)(book->hdr + 1);
+    if (book->hdr->magic != BOOK_MAGIC || book->hdr->version != BOOK_VERSION ||
+        book->len != sizeof(BookHeader) + (size_t)book->hdr->count * sizeof(BookEntry)) {
+        book_close(book);
+        return -1;
+    }
+    // Хоёртын хайлт санамсаргүй хуудас уншдаг тул урьдчилан уншихгүй
+    madvise(book->map, book->len, MADV_RANDOM);
+    return 0;
+}
+
+void book_close(Book *book) {
+    Munmap(book->map, book->len);
+    memset(book, 0, sizeof(*book));
+}
+
+int book_probe(const Book *book, int size, int win_len, const char *cells, char player,
+               int *row, int *col, const BookEntry **entry) {
+    int stones = 0, sym;
+
+    for (int cell = 0; cell < size * size; cell++)
+        if (cells[cell] != ' ' && ++stones > (int)book->hdr->max_stones)
+            return 0;
+
+    uint64_t key = book_key(size, win_len, cells, player, &sym);
+    size_t lo = 0, hi = book->hdr->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (book->entries[mid].key < key) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == book->hdr->count || book->entries[lo].key != key) return 0;
+
+    const BookEntry *e = &book->entries[lo];
+    book_untransform(size, sym, e->row, e->col, row, col);
+    // Хэшийн давхцлаас хамгаална
+    if (*row >= size || *col >= size || cells[*row * size + *col] != ' ') return 0;
+    if (entry) *entry = e;
+    return 1;
+}
@@ -0,0 +1,67 @@
+/*
+ * book.h - Нээлтийн ном (opening book)
+ *
+ * bookgen-ээр урьдчилан хайж бэлдсэн байрлал -> нүүдлийн файл. Мөрүүд
+ * түлхүүрээрээ эрэмбэлэгдсэн тул серверт Mmap хийгээд хоёртын хайлтаар
+ * уншина: эхлэхэд файлыг уншихгүй, олон серверийн процесс page cache-ийн
+ * нэг хуулбарыг хуваалцана. Самбарын 8 тэгш хэмийн (эргүүлэх, тусгах)
+ * хамгийн бага хэшийг түлхүүр болгодог тул тэгш хэмтэй байрлалууд нэг
+ * мөрөөр илэрнэ, нүүдэл нь тэр каноник хэлбэрийн координатаар хадгалагдана.
+ */
+#ifndef __BOOK_H__
+#define __BOOK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BOOK_MAGIC 0x4b424f58u    // "XOBK"
+#define BOOK_VERSION 1
+
+// Файлын эхэнд, араас нь count ширхэг BookEntry
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t max_stones;        // Үүнээс олон чулуутай байрлал номонд байхгүй
+} BookHeader;
+
+typedef struct {
+    uint64_t key;               // book_key
+    uint8_t row, col;           // Каноник хэлбэр дээрх нүүдэл
+    uint8_t depth;              // bookgen-ий хайлтын гүн
+    uint8_t pad;
+    int32_t score;
+} BookEntry;
+
+typedef struct {
+    void *map;
+    size_t len;
+    const BookHeader *hdr;
+    const BookEntry *entries;
+} Book;
+
+/*
+ * book_key - size x size cells (board_snapshot-ийн хэлбэр) дээр player
+ *     нүүх байрлалын түлхүүр. sym-д каноник хэлбэрт шилжүүлэх тэгш хэмийг буцаана
+ */
+uint64_t book_key(int size, int win_len, const char *cells, char player, int *sym);
+
+// (row, col)-ийг sym тэгш хэмээр шилжүүлэх ба буцаах
+void book_transform(int size, int sym, int row, int col, int *r, int *c);
+void book_untransform(int size, int sym, int row, int col, int *r, int *c);
+
+/*
+ * book_open - path-ийг уншихаар map хийх. Файл буруу бол -1
+ * book_close - map-ийг чөлөөлөх
+ */
+int book_open(Book *book, const char *path);
+void book_close(Book *book);
+
+/*
+ * book_probe - байрлал номонд байвал нүүдлийг (row, col)-д, мөрийг
+ *     entry-д өгч 1 буцаана
+ */
+int book_probe(const Book *book, int size, int win_len, const char *cells, char player,
+               int *row, int *col, const BookEntry **entry);
+
+#endif /* __BOOK_H__ */
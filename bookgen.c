@@ -0,0 +1,185 @@
+/*
+ * bookgen.c - Нээлтийн ном үүсгэх
+ *
+ * Хоосон самбараас эхлэн хоёр талын аль нэгийг номын тал болгож, түүний
+ * ээлжинд ai_search-ийн сонгосон ганц нүүдлийг, өрсөлдөгчийн ээлжинд
+ * чулуунуудаас radius зайд байгаа бүх нүдийг (хоосон самбарт бүх нүдийг)
+ * дэлгэнэ. Тэгш хэмтэй байрлалуудыг каноник түлхүүрээр нь нэг удаа л хайна.
+ */
+#include "csapp.h"
+#include "ai.h"
+#include "book.h"
+#include "pattern.h"
+#include "proto.h"
+
+#define BOOKGEN_PLIES 4
+#define BOOKGEN_BUDGET_MS 100
+#define BOOKGEN_RADIUS 1
+
+typedef struct {
+    Board b;
+    int plies, budget_ms, threads, radius;
+    uint64_t *seen;             // Нээлттэй хаягжилттай хэш олонлог, 0 = хоосон
+    size_t seen_cap, seen_count;
+    BookEntry *entries;
+    size_t count, cap;
+    unsigned long nodes;
+} Gen;
+
+static int seen_insert(Gen *g, uint64_t key);
+
+static void seen_grow(Gen *g) {
+    uint64_t *old = g->seen;
+    size_t cap = g->seen_cap;
+
+    g->seen_cap = cap ? cap * 2 : 1024;
+    g->seen = Calloc(g->seen_cap, sizeof(uint64_t));
+    g->seen_count = 0;
+    for (size_t i = 0; i < cap; i++)
+        if (old[i]) seen_insert(g, old[i]);
+    Free(old);
+}
+
+// Шинэ бол 1
+static int seen_insert(Gen *g, uint64_t key) {
+    if (!key) key = 1;
+    if (2 * (g->seen_count + 1) > g->seen_cap) seen_grow(g);
+    size_t mask = g->seen_cap - 1;
+    for (size_t i = key & mask; ; i = (i + 1) & mask) {
+        if (g->seen[i] == key) return 0;
+        if (!g->seen[i]) {
+            g->seen[i] = key;
+            g->seen_count++;
+            return 1;
+        }
+    }
+}
+
+static void add_entry(Gen *g, uint64_t key, int sym, AiMove *m) {
+    if (g->count == g->cap) {
+        g->cap = g->cap ? g->cap * 2 : 256;
+        g->entries = Realloc(g->entries, g->cap * sizeof(BookEntry));
+    }
+    BookEntry *e = &g->entries[g->count++];
+    int r, c;
+    book_transform(g->b.size, sym, m->row, m->col, &r, &c);
+    memset(e, 0, sizeof(*e));
+    e->key = key;
+    e->row = r;
+    e->col = c;
+    e->depth = m->depth;
+    e->score = m->score;
+}
+
+static int near_stone(Board *b, int row, int col, int radius) {
+    int n = b->size;
+
+    for (int r = row - radius; r <= row + radius; r++)
+        for (int c = col - radius; c <= col + radius; c++)
+            if (r >= 0 && r < n && c >= 0 && c < n && b->cells[r * n + c] != ' ')
+                return 1;
+    return 0;
+}
+
+static void expand(Gen *g, int ply, char player, char side) {
+    Board *b = &g->b;
+    int n = b->size, sym;
+    char opp = player == 'X' ? 'O' : 'X';
+
+    if (ply >= g->plies) return;
+    uint64_t key = book_key(n, b->win_len, b->cells, player, &sym);
+    if (!seen_insert(g, key)) return;
+
+    if (player == side) {
+        AiMove m;
+        ai_search(b, player, g->budget_ms, g->threads, &m);
+        g->nodes += m.nodes;
+        if (m.row < 0) return;
+        add_entry(g, key, sym, &m);
+        board_place(b, m.row, m.col, player);
+        if (!board_check_win(b, m.row, m.col, player))
+            expand(g, ply + 1, opp, side);
+        board_undo(b, m.row, m.col);
+        return;
+    }
+
+    for (int cell = 0; cell < n * n; cell++) {
+        int row = cell / n, col = cell % n;
+        if (b->cells[cell] != ' ' || (b->stones && !near_stone(b, row, col, g->radius)))
+            continue;
+        board_place(b, row, col, player);
+        if (!board_check_win(b, row, col, player))
+            expand(g, ply + 1, opp, side);
+        board_undo(b, row, col);
+    }
+}
+
+static int entry_cmp(const void *a, const void *b) {
+    uint64_t x = ((const BookEntry *)a)->key, y = ((const BookEntry *)b)->key;
+    return x < y ? -1 : x > y;
+}
+
+int main(int argc, char **argv) {
+    int opt, size = DEFAULT_BOARD_SIZE, win_len = DEFAULT_WIN_LENGTH;
+    Gen g;
+
+    memset(&g, 0, sizeof(g));
+    g.plies = BOOKGEN_PLIES;
+    g.budget_ms = BOOKGEN_BUDGET_MS;
+    g.threads = 1;
+    g.radius = BOOKGEN_RADIUS;
+    while ((opt = getopt(argc, argv, "s:w:p:b:j:r:")) != -1) {
+        switch (opt) {
+        case 's': size = atoi(optarg); break;
+        case 'w': win_len = atoi(optarg); break;
+        case 'p': g.plies = atoi(optarg); break;
+        case 'b': g.budget_ms = atoi(optarg); break;
+        case 'j': g.threads = atoi(optarg); break;
+        case 'r': g.radius = atoi(optarg); break;
+        default: argc = 0;
+        }
+    }
+    if (argc - optind != 1 || size < MIN_BOARD_SIZE || size > MAX_BOARD_SIZE || win_len < MIN_WIN_LENGTH ||
+        win_len > MAX_WIN_LENGTH || win_len > size || g.plies < 1 || g.budget_ms < 1 || g.threads < 1 ||
+        g.threads > AI_MAX_THREADS || g.radius < 1) {
+        fprintf(stderr, "Usage: %s [-s board_size] [-w win_length] [-p plies] [-b budget_ms] "
+                "[-j threads] [-r reply_radius] <out.book>\n", argv[0]);
+        exit(0);
+    }
+
+    pattern_init();
+    ai_init(g.threads);
+    board_init(&g.b, BOARD_BITBOARD, size, win_len);
+    // AI аль ч талд тоглож болох тул хоёр талын номыг нэг файлд
+    for (int side = 0; side < 2; side++) {
+        // Өрсөлдөгчийн ээлжийн байрлал хоёр талд давтагдана
+        if (g.seen) memset(g.seen, 0, g.seen_cap * sizeof(uint64_t));
+        g.seen_count = 0;
+        expand(&g, 0, 'X', side ? 'O' : 'X');
+    }
+    board_free(&g.b);
+    qsort(g.entries, g.count, sizeof(BookEntry), entry_cmp);
+
+    BookHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = BOOK_MAGIC;
+    hdr.version = BOOK_VERSION;
+    hdr.count = g.count;
+    hdr.max_stones = g.plies - 1;
+
+    // Ажиллаж буй серверүүд хуучин файлыг map хийсэн байж болох тул
+    // шинийг тусад нь бичээд rename-ээр солино
+    char tmp[MAXLINE];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", argv[optind]);
+    int fd = Open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    Rio_writen(fd, &hdr, sizeof(hdr));
+    Rio_writen(fd, g.entries, g.count * sizeof(BookEntry));
+    Close(fd);
+    if (rename(tmp, argv[optind]) < 0)
+        unix_error("rename error");
+
+    printf("%zu positions, %lu nodes searched\n", g.count, g.nodes);
+    Free(g.entries);
+    Free(g.seen);
+    return 0;
+}
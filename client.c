@@ -1,26 +1,38 @@
 #include "csapp.h"
+#include "proto.h"
 #include <stdint.h>
 #include <time.h>
+#include <netinet/tcp.h>
 
-#define BOARD_SIZE 20
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
 #define ANSI_COLOR_BLUE    "\x1b[34m"
 #define ANSI_COLOR_YELLOW  "\x1b[33m"
 #define ANSI_COLOR_RESET   "\x1b[0m"
 #define MOVE_TIMEOUT 30  // нэг хөдөлгөөнд хийх хугацаа
+#define VIEW_RADIUS 10   // Хязгааргүй самбараас харуулах хүрээ
+#define VIEW_SIZE (2 * VIEW_RADIUS + 1)
+#define RESUME_TRIES 10  // Холболт тасрахад дахин холбогдох оролдлого
+#define RESUME_DELAY_MS 1000
 
-void display_board(char board[][BOARD_SIZE]) {
+// Хязгааргүй самбарын чулуу
+typedef struct {
+    int row, col;
+    char symbol;
+} Stone;
+
+// (row0, col0) нь board[0][0]-ийн бодит координат
+void display_board(int n, char board[][n], int row0, int col0) {
     printf("\nCurrent Board State:\n");
     printf("  ");
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        printf(" %2d", i);
+    for (int i = 0; i < n; i++) {
+        printf(" %2d", col0 + i);
     }
     printf("\n");
     
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        printf("%2d ", i);
-        for (int j = 0; j < BOARD_SIZE; j++) {
+    for (int i = 0; i < n; i++) {
+        printf("%2d ", row0 + i);
+        for (int j = 0; j < n; j++) {
             if (board[i][j] == 'X') {
                 printf(ANSI_COLOR_RED " X " ANSI_COLOR_RESET);
             } else if (board[i][j] == 'O') {
@@ -34,54 +46,246 @@ void display_board(char board[][BOARD_SIZE]) {
     printf("\n");
 }
 
+// Сүүлийн чулууны орчмыг харуулах
+void display_stones(Stone *stones, int count) {
+    char view[VIEW_SIZE][VIEW_SIZE];
+    int row0 = (count ? stones[count - 1].row : 0) - VIEW_RADIUS;
+    int col0 = (count ? stones[count - 1].col : 0) - VIEW_RADIUS;
+
+    memset(view, ' ', sizeof(view));
+    for (int i = 0; i < count; i++) {
+        int r = stones[i].row - row0, c = stones[i].col - col0;
+        if (r >= 0 && r < VIEW_SIZE && c >= 0 && c < VIEW_SIZE)
+            view[r][c] = stones[i].symbol;
+    }
+    display_board(VIEW_SIZE, view, row0, col0);
+}
+
+// Хөдөлгөөн асуух. "h" бол зөвлөгөө хүсээд MSG_ADVICE ирэхэд дахин асууна
+static void prompt_move(int connfd, int size) {
+    char line[MAXLINE];
+
+    while (1) {  // Хүчинтэй хөдөлгөөн хийх хүртэл давтах
+        printf(ANSI_COLOR_YELLOW "Your move (row col, or h for a hint): " ANSI_COLOR_RESET);
+        fflush(stdout);
+        if (!fgets(line, sizeof(line), stdin)) exit(0);
+        if (line[0] == 'h') {
+            write_frame(connfd, MSG_HINT, NULL, 0);
+            return;
+        }
+        int row, col;
+        if (sscanf(line, "%d %d", &row, &col) != 2) continue;
+
+        // Үндсэн оролтын хүчинтэй эсэхийн шалгалт
+        if (size && (row < 0 || row >= size || col < 0 || col >= size)) {
+            printf(ANSI_COLOR_RED "Invalid position! Please enter numbers between 0 and %d\n" ANSI_COLOR_RESET,
+                   size - 1);
+            continue;
+        }
+
+        // Мөр, баганыг нэг фреймээр
+        char move[8];
+        put_u32(move, row);
+        put_u32(move + 4, col);
+        write_frame(connfd, MSG_PLAY, move, sizeof(move));
+        return;
+    }
+}
+
+/*
+ * Холбогдож HELLO илгээгээд WELCOME-ийг reply-д авах. Холбогдож чадаагүй
+ * бол -1, сервер татгалзвал шалтгааныг reply-д хийж -2
+ */
+static int client_connect(char *host, char *port, char *hello, size_t hello_len, char *reply, size_t maxlen) {
+    int connfd = open_clientfd(host, port);
+    if (connfd < 0) return -1;
+    int one = 1;
+    setsockopt(connfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    char type;
+    ssize_t len = write_frame(connfd, MSG_HELLO, hello, hello_len) < 0 ? -1 :
+                  read_frame(connfd, &type, reply, maxlen - 1);
+    if (len < 0) {
+        close(connfd);
+        return -1;
+    }
+    if (type != MSG_WELCOME || len < WELCOME_MSG_SIZE) {
+        reply[len] = '\0';
+        if (type != MSG_ERROR) strcpy(reply, "bad handshake");
+        close(connfd);
+        return -2;
+    }
+    return connfd;
+}
+
 int main(int argc, char **argv) {
-    if (argc != 3) {
-        fprintf(stderr, "Usage: %s <host> <port>\n", argv[0]);
+    uint32_t flags = 0;
+    int opt, threads = 0, game = 0;
+    // -a: серверийн AI-тай тоглох, -j: AI-ийн хайлтын thread,
+    // -w: тоглоомыг үзэх (0 = сүүлд эхэлсэн)
+    while ((opt = getopt(argc, argv, "aj:w:")) != -1) {
+        if (opt == 'a') flags |= HELLO_VS_AI;
+        else if (opt == 'j') threads = atoi(optarg);
+        else if (opt == 'w') flags |= HELLO_SPECTATE, game = atoi(optarg);
+        else argc = optind;
+    }
+    if (argc - optind < 2 || argc - optind > 4) {
+        fprintf(stderr, "Usage: %s [-a [-j threads] | -w game] <host> <port> [board_size|inf [win_length]]\n", argv[0]);
         exit(0);
     }
+    // Үлдсэн аргументуудыг argv[1]-ээс эхлүүлэх
+    argv += optind - 1;
+    argc -= optind - 1;
+    // "inf" бол хязгааргүй самбар
+    if (argc > 3 && !strcmp(argv[3], "inf")) flags |= HELLO_UNBOUNDED;
+    int size = argc > 3 && !(flags & HELLO_UNBOUNDED) ? atoi(argv[3]) : DEFAULT_BOARD_SIZE;
+    int win_len = argc > 4 ? atoi(argv[4]) : DEFAULT_WIN_LENGTH;
 
-    int connfd = Open_clientfd(argv[1], argv[2]);
-    char symbol;
-    Rio_readn(connfd, &symbol, 1);
-    printf("You are %c\n", symbol);
-    printf("You have %d seconds to make each move\n", MOVE_TIMEOUT);
+    // Тасарсан сокет руу бичихэд процесс унахгүй, дахин холбогдоно
+    Signal(SIGPIPE, SIG_IGN);
+
+    // Хувилбар, хүссэн самбараа мэдэгдэх. Дахин холбогдоход token, seq-ийг нэмнэ
+    char hello[HELLO_RESUME_SIZE];
+    memset(hello, 0, sizeof(hello));
+    put_u32(hello, PROTO_VERSION);
+    put_u32(hello + 4, size);
+    put_u32(hello + 8, win_len);
+    put_u32(hello + 12, flags);
+    put_u32(hello + HELLO_AI_THREADS, threads);
+    put_u32(hello + HELLO_GAME, game);
+
+    char reply[256];
+    int connfd = client_connect(argv[1], argv[2], hello, HELLO_GAME + 4, reply, sizeof(reply));
+    if (connfd == -1) {
+        fprintf(stderr, "Could not connect to %s:%s\n", argv[1], argv[2]);
+        exit(1);
+    }
+    if (connfd < 0) {
+        fprintf(stderr, "Server rejected the game: %s\n", reply);
+        exit(1);
+    }
+    size = get_u32(reply + 4);
+    win_len = get_u32(reply + 8);
+    if (flags & HELLO_SPECTATE)
+        printf("Watching a game on %s board, %d in a row wins\n", size ? "a bounded" : "an unbounded", win_len);
+    else if (flags & HELLO_VS_AI)
+        printf("Playing against the server AI on a %dx%d board, %d in a row wins\n", size, size, win_len);
+    else if (size)
+        printf("Waiting for an opponent on a %dx%d board, %d in a row wins\n", size, size, win_len);
+    else
+        printf("Waiting for an opponent on an unbounded board, %d in a row wins\n", win_len);
+
+    // Сервер эхлээд бүтэн самбар, дараа нь зөвхөн хөдөлгөөнүүдийг илгээнэ.
+    // Хязгааргүй самбарт самбарын оронд чулуунуудын жагсаалт хадгална
+    char (*board)[size] = size ? Malloc(size * size) : NULL;
+    Stone *stones = NULL;
+    int nstones = 0, stones_cap = 0;
+    size_t max_msg = size ? 4 + size * size : FRAME_MAX_BODY;
+    char *msg = Malloc(max_msg);
+    char symbol = '?';
+    uint32_t seq = 0;
+    int resyncing = 1;
+    int have_token = 0;
 
     while (1) {
         char msg_type;
-        Rio_readn(connfd, &msg_type, 1);
-
-        if (msg_type == 'B') {
-            char board[BOARD_SIZE][BOARD_SIZE];
-            Rio_readn(connfd, board, BOARD_SIZE * BOARD_SIZE);
-            display_board(board);
-        } else if (msg_type == 'T') {
-            while (1) {  // Хүчинтэй хөдөлгөөн хийх хүртэл давтах
-                printf(ANSI_COLOR_YELLOW "Your move (row col): " ANSI_COLOR_RESET);
-                int row, col;
-                scanf("%d %d", &row, &col);
-                
-                // Үндсэн оролтын хүчинтэй эсэхийн шалгалт
-                if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
-                    printf(ANSI_COLOR_RED "Invalid position! Please enter numbers between 0 and %d\n" ANSI_COLOR_RESET, 
-                           BOARD_SIZE - 1);
-                    continue;
+        ssize_t len = read_frame(connfd, &msg_type, msg, max_msg);
+        if (len < 0) {
+            close(connfd);
+            connfd = -1;
+            if (!have_token) {
+                printf(ANSI_COLOR_RED "Connection to server lost\n" ANSI_COLOR_RESET);
+                break;
+            }
+            // Сүүлд авсан seq-ээс хойшхыг л сервер дахин илгээнэ. Самбар хүлээж
+            // байсан бол seq-ийг хүчингүй болгож бүтэн самбар авна
+            printf(ANSI_COLOR_YELLOW "Connection lost, reconnecting...\n" ANSI_COLOR_RESET);
+            put_u32(hello + 12, flags | HELLO_RESUME);
+            put_u32(hello + HELLO_LAST_SEQ, resyncing ? UINT32_MAX : seq);
+            for (int i = 0; i < RESUME_TRIES && connfd == -1; i++) {
+                struct timespec ts = {RESUME_DELAY_MS / 1000, RESUME_DELAY_MS % 1000 * 1000000L};
+                nanosleep(&ts, NULL);
+                connfd = client_connect(argv[1], argv[2], hello, sizeof(hello), reply, sizeof(reply));
+            }
+            if (connfd < 0) {
+                printf(ANSI_COLOR_RED "Could not resume the game: %s\n" ANSI_COLOR_RESET,
+                       connfd == -1 ? "server unreachable" : reply);
+                break;
+            }
+            printf(ANSI_COLOR_GREEN "Resumed the game\n" ANSI_COLOR_RESET);
+            continue;
+        }
+
+        if (msg_type == MSG_SESSION && len == SESSION_MSG_SIZE) {
+            memcpy(hello + HELLO_TOKEN, msg, SESSION_MSG_SIZE);
+            have_token = 1;
+        } else if (msg_type == MSG_SEAT && len == 1) {
+            symbol = msg[0];
+            printf("You are %c\n", symbol);
+            printf("You have %d seconds to make each move\n", MOVE_TIMEOUT);
+        } else if (msg_type == MSG_BOARD && len == max_msg) {
+            seq = get_u32(msg);
+            memcpy(board, msg + 4, size * size);
+            resyncing = 0;
+            display_board(size, board, 0, 0);
+        } else if (msg_type == MSG_STONES && !size && len >= 4 && (len - 4) % STONE_SIZE == 0) {
+            seq = get_u32(msg);
+            nstones = (len - 4) / STONE_SIZE;
+            if (nstones > stones_cap) {
+                stones_cap = nstones;
+                stones = Realloc(stones, stones_cap * sizeof(Stone));
+            }
+            for (int i = 0; i < nstones; i++) {
+                char *p = msg + 4 + i * STONE_SIZE;
+                stones[i].row = (int)get_u32(p);
+                stones[i].col = (int)get_u32(p + 4);
+                stones[i].symbol = p[8];
+            }
+            resyncing = 0;
+            display_stones(stones, nstones);
+        } else if (msg_type == MSG_MOVE && len == MOVE_MSG_SIZE) {
+            if (resyncing) continue;  // Бүтэн самбар ирэх хүртэл алгасах
+            int row = get_u32(msg + 4), col = get_u32(msg + 8);
+            if (get_u32(msg) != seq + 1 || (size && (row < 0 || row >= size || col < 0 || col >= size))) {
+                // Хөдөлгөөн алдагдсан тул бүтэн самбар хүсэх
+                write_frame(connfd, MSG_RESYNC, NULL, 0);
+                resyncing = 1;
+                continue;
+            }
+            seq++;
+            if (!size) {
+                if (nstones == stones_cap) {
+                    stones_cap = stones_cap ? 2 * stones_cap : 64;
+                    stones = Realloc(stones, stones_cap * sizeof(Stone));
                 }
-                
-                int row_net = htonl(row);
-                int col_net = htonl(col);
-                Rio_writen(connfd, &row_net, sizeof(row_net));
-                Rio_writen(connfd, &col_net, sizeof(col_net));
-                break;  // Хөдөлгөөнийг илгээсний дараа давталтаас гарах
+                stones[nstones++] = (Stone){row, col, msg[12]};
+                display_stones(stones, nstones);
+                continue;
             }
-        } else if (msg_type == 'G') {
-            int winner_net;
-            Rio_readn(connfd, &winner_net, sizeof(winner_net));
-            int winner = ntohl(winner_net);
-            if (winner == -1)
+            board[row][col] = msg[12];
+            display_board(size, board, 0, 0);
+        } else if (msg_type == MSG_TURN) {
+            prompt_move(connfd, size);
+        } else if (msg_type == MSG_ADVICE && len == ADVICE_MSG_SIZE) {
+            int row = (int)get_u32(msg), col = (int)get_u32(msg + 4);
+            if (row >= 0)
+                printf(ANSI_COLOR_GREEN "Hint: play (%d, %d), it wins by force in %d moves\n" ANSI_COLOR_RESET,
+                       row, col, (int)get_u32(msg + 8));
+            else
+                printf("Hint: no forced win found (searched %u positions)\n", get_u32(msg + 12));
+            prompt_move(connfd, size);
+        } else if (msg_type == MSG_ERROR) {
+            printf(ANSI_COLOR_RED "Server error: %.*s\n" ANSI_COLOR_RESET, (int)len, msg);
+            break;
+        } else if (msg_type == MSG_GAMEOVER && len == 4) {
+            int winner = (int)get_u32(msg);
+            if (winner == GAMEOVER_DRAW)
                 printf(ANSI_COLOR_YELLOW "Game ended in a draw!\n" ANSI_COLOR_RESET);
+            else if (flags & HELLO_SPECTATE)
+                printf(ANSI_COLOR_YELLOW "Player %c wins!\n" ANSI_COLOR_RESET, winner ? 'O' : 'X');
             else if ((winner == 0 && symbol == 'X') || (winner == 1 && symbol == 'O'))
                 printf(ANSI_COLOR_GREEN "Congratulations! You win!\n" ANSI_COLOR_RESET);
-            else if (winner == -3)
+            else if (winner == GAMEOVER_TIMEOUT)
                 printf(ANSI_COLOR_RED "You lost due to timeout!\n" ANSI_COLOR_RESET);
             else
                 printf(ANSI_COLOR_RED "You lose!\n" ANSI_COLOR_RESET);
@@ -89,6 +293,9 @@ int main(int argc, char **argv) {
         }
     }
 
-    Close(connfd);
+    Free(board);
+    Free(stones);
+    Free(msg);
+    if (connfd >= 0) Close(connfd);
     return 0;
-}
\ No newline at end of file
+}
@@ -893,6 +893,62 @@ ssize_t rio_readlineb(rio_t *rp, void *usrbuf, size_t maxlen)
 }
 /* $end rio_readlineb */
 
+/*
+ * rio_fillb_nb - Non-blocking refill for event-driven servers. Reads what
+ *     is available into the free tail of the buffer without discarding
+ *     unread bytes, so a partial frame survives until the rest arrives.
+ *     Unread bytes are moved to the front only when the tail is full.
+ *     Returns bytes read, 0 on EOF, or -1 with errno set (EAGAIN if no
+ *     data is ready, ENOBUFS if the buffer is full of unread bytes).
+ *     Never exits the process.
+ */
+/* $begin rio_fillb_nb */
+ssize_t rio_fillb_nb(rio_t *rp)
+{
+    char *end = rp->rio_bufptr + rp->rio_cnt;
+    ssize_t n;
+
+    if (end == rp->rio_buf + RIO_BUFSIZE) {
+	if (rp->rio_cnt == RIO_BUFSIZE) {
+	    errno = ENOBUFS;
+	    return -1;
+	}
+	memmove(rp->rio_buf, rp->rio_bufptr, rp->rio_cnt);
+	rp->rio_bufptr = rp->rio_buf;
+	end = rp->rio_buf + rp->rio_cnt;
+    }
+    while ((n = read(rp->rio_fd, end, rp->rio_buf + RIO_BUFSIZE - end)) < 0)
+	if (errno != EINTR) /* Interrupted by sig handler return */
+	    return -1;
+    rp->rio_cnt += n;
+    return n;
+}
+/* $end rio_fillb_nb */
+
+/*
+ * rio_peekb - Zero-copy view of the unread bytes, returns their count
+ */
+/* $begin rio_peekb */
+ssize_t rio_peekb(rio_t *rp, char **bufp)
+{
+    *bufp = rp->rio_bufptr;
+    return rp->rio_cnt;
+}
+/* $end rio_peekb */
+
+/*
+ * rio_consumeb - Mark n bytes returned by rio_peekb as read
+ */
+/* $begin rio_consumeb */
+void rio_consumeb(rio_t *rp, size_t n)
+{
+    rp->rio_bufptr += n;
+    rp->rio_cnt -= n;
+    if (rp->rio_cnt == 0)     /* Refill from the start next time */
+	rp->rio_bufptr = rp->rio_buf;
+}
+/* $end rio_consumeb */
+
 /**********************************
  * Wrappers for robust I/O routines
  **********************************/
@@ -985,16 +1041,12 @@ int open_clientfd(char *hostname, char *port) {
 }
 /* $end open_clientfd */
 
-/*  
- * open_listenfd - Open and return a listening socket on port. This
- *     function is reentrant and protocol-independent.
- *
- *     On error, returns: 
- *       -2 for getaddrinfo error
- *       -1 with errno set for other errors.
+/*
+ * open_listenfd_opts - Common body of open_listenfd,
+ *     open_listenfd_reuseport and open_listenfd_host. A NULL host
+ *     means any IP address.
  */
-/* $begin open_listenfd */
-int open_listenfd(char *port) 
+static int open_listenfd_opts(char *host, char *port, int reuseport) 
 {
     struct addrinfo hints, *listp, *p;
     int listenfd, rc, optval=1;
@@ -1002,9 +1054,11 @@ int open_listenfd(char *port)
     /* Get a list of potential server addresses */
     memset(&hints, 0, sizeof(struct addrinfo));
     hints.ai_socktype = SOCK_STREAM;             /* Accept connections */
-    hints.ai_flags = AI_PASSIVE | AI_ADDRCONFIG; /* ... on any IP address */
+    hints.ai_flags = AI_PASSIVE;                 /* ... on any IP address */
+    if (!host)
+        hints.ai_flags |= AI_ADDRCONFIG;
     hints.ai_flags |= AI_NUMERICSERV;            /* ... using port number */
-    if ((rc = getaddrinfo(NULL, port, &hints, &listp)) != 0) {
+    if ((rc = getaddrinfo(host, port, &hints, &listp)) != 0) {
         fprintf(stderr, "getaddrinfo failed (port %s): %s\n", port, gai_strerror(rc));
         return -2;
     }
@@ -1019,6 +1073,13 @@ int open_listenfd(char *port)
         setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR,    //line:netp:csapp:setsockopt
                    (const void *)&optval , sizeof(int));
 
+        /* Lets other sockets bind the same port */
+        if (reuseport && setsockopt(listenfd, SOL_SOCKET, SO_REUSEPORT,
+                                    (const void *)&optval, sizeof(int)) < 0) {
+            close(listenfd);
+            continue;
+        }
+
         /* Bind the descriptor to the address */
         if (bind(listenfd, p->ai_addr, p->ai_addrlen) == 0)
             break; /* Success */
@@ -1041,8 +1102,41 @@ int open_listenfd(char *port)
     }
     return listenfd;
 }
+
+/*  
+ * open_listenfd - Open and return a listening socket on port. This
+ *     function is reentrant and protocol-independent.
+ *
+ *     On error, returns: 
+ *       -2 for getaddrinfo error
+ *       -1 with errno set for other errors.
+ */
+/* $begin open_listenfd */
+int open_listenfd(char *port) 
+{
+    return open_listenfd_opts(NULL, port, 0);
+}
 /* $end open_listenfd */
 
+/*  
+ * open_listenfd_reuseport - Like open_listenfd, but also sets
+ *     SO_REUSEPORT so that several sockets (one per thread) can bind
+ *     the same port and let the kernel balance incoming connections.
+ */
+int open_listenfd_reuseport(char *port) 
+{
+    return open_listenfd_opts(NULL, port, 1);
+}
+
+/*  
+ * open_listenfd_host - Like open_listenfd, but binds only the given
+ *     host address (e.g. "127.0.0.1") instead of every interface.
+ */
+int open_listenfd_host(char *host, char *port) 
+{
+    return open_listenfd_opts(host, port, 0);
+}
+
 /****************************************************
  * Wrappers for reentrant protocol-independent helpers
  ****************************************************/
@@ -1064,4 +1158,22 @@ int Open_listenfd(char *port)
     return rc;
 }
 
+int Open_listenfd_reuseport(char *port) 
+{
+    int rc;
+
+    if ((rc = open_listenfd_reuseport(port)) < 0)
+	unix_error("Open_listenfd_reuseport error");
+    return rc;
+}
+
+int Open_listenfd_host(char *host, char *port) 
+{
+    int rc;
+
+    if ((rc = open_listenfd_host(host, port)) < 0)
+	unix_error("Open_listenfd_host error");
+    return rc;
+}
+
 /* $end csapp.c */
@@ -0,0 +1,115 @@
+/*
+ * hist.c - HDR маягийн хоцрогдлын гистограм
+ */
+#include "hist.h"
+#include <string.h>
+#include <math.h>
+
+void hist_init(Hist *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = UINT64_MAX;
+}
+
+// HIST_SUB-ээс бага утга шууд индекс; бусад нь b = msb - HIST_SUB_BITS + 1 мужийн
+// [HIST_HALF, HIST_SUB) дэд бакет, муж бүр өмнөхийнхөө араас үргэлжилнэ
+static inline int hist_index(uint64_t v) {
+    if (v < HIST_SUB) return (int)v;
+    int b = 63 - __builtin_clzll(v) - HIST_SUB_BITS + 1;
+    return b * HIST_HALF + (int)(v >> b);
+}
+
+// Бакетэд буух хамгийн бага, их утга
+static uint64_t hist_lowest(int i) {
+    if (i < HIST_SUB) return i;
+    int b = i / HIST_HALF - 1;
+    return (uint64_t)(i - b * HIST_HALF) << b;
+}
+
+static uint64_t hist_highest(int i) {
+    if (i < HIST_SUB) return i;
+    int b = i / HIST_HALF - 1;
+    uint64_t sub = i - b * HIST_HALF;
+    return (sub << b) + ((1ULL << b) - 1);
+}
+
+// Эзэмшигч thread-ийн бичилт, бусад нь hist_merge-ээр зэрэг уншиж болно.
+// Relaxed store нь x86 дээр энгийн mov тул бичилтэд нэмэлт зардалгүй
+#define HIST_STORE(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+#define HIST_LOAD(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+
+void hist_record(Hist *h, uint64_t v) {
+    int i = hist_index(v);
+    HIST_STORE(&h->counts[i], h->counts[i] + 1);
+    HIST_STORE(&h->total, h->total + 1);
+    HIST_STORE(&h->sum, h->sum + v);
+    if (v < h->min) HIST_STORE(&h->min, v);
+    if (v > h->max) HIST_STORE(&h->max, v);
+}
+
+void hist_merge(Hist *dst, const Hist *src) {
+    // total-ыг бакетуудаас дахин тоолж, зэрэг бичилттэй ч нийцтэй байлгана
+    uint64_t total = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        uint64_t n = HIST_LOAD(&src->counts[i]);
+        dst->counts[i] += n;
+        total += n;
+    }
+    if (!total) return;
+    dst->total += total;
+    dst->sum += HIST_LOAD(&src->sum);
+    uint64_t min = HIST_LOAD(&src->min), max = HIST_LOAD(&src->max);
+    if (min < dst->min) dst->min = min;
+    if (max > dst->max) dst->max = max;
+}
+
+uint64_t hist_count_le(const Hist *h, uint64_t v) {
+    uint64_t count = 0;
+    for (int i = 0; i < HIST_BUCKETS && hist_highest(i) <= v; i++) count += h->counts[i];
+    return count;
+}
+
+uint64_t hist_percentile(const Hist *h, double p) {
+    if (!h->total) return 0;
+    uint64_t want = (uint64_t)ceil(p / 100.0 * h->total), seen = 0;
+    if (want < 1) want = 1;
+    for (int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= want) {
+            uint64_t v = hist_highest(i);
+            return v > h->max ? h->max : v;
+        }
+    }
+    return h->max;
+}
+
+double hist_mean(const Hist *h) {
+    return h->total ? (double)h->sum / h->total : 0.0;
+}
+
+void hist_print(FILE *out, const Hist *h, double scale) {
+    fprintf(out, "%12s %14s %10s %14s\n\n", "Value", "Percentile", "TotalCount", "1/(1-Percentile)");
+    if (!h->total) return;
+
+    // HdrHistogram-ийн адил: үлдсэн хэсгийг хоёр дахин хуваах бүрт 5 мөр,
+    // үлдэх тоо 1-ээс багасахад 100%-ийн мөрөөр дуусна
+    for (int k = 0; ldexp((double)h->total, -k) >= 1.0; k++)
+        for (int j = 0; j < 5; j++) {
+            double pct = 1.0 - ldexp(1.0, -k) + j * ldexp(1.0, -k - 1) / 5;
+            uint64_t count = (uint64_t)ceil(pct * h->total);
+            if (count < 1) count = 1;
+            fprintf(out, "%12.3f %14.12f %10llu %14.2f\n", hist_percentile(h, pct * 100) / scale, pct,
+                    (unsigned long long)count, 1.0 / (1.0 - pct));
+        }
+    fprintf(out, "%12.3f %14.12f %10llu\n", h->max / scale, 1.0, (unsigned long long)h->total);
+
+    // HdrHistogram-ийн адил хазайлтыг бакетын дундаж утгаар
+    double mean = hist_mean(h), var = 0;
+    for (int i = 0; i < HIST_BUCKETS; i++)
+        if (h->counts[i]) {
+            double d = (hist_lowest(i) + hist_highest(i)) / 2.0 - mean;
+            var += d * d * h->counts[i];
+        }
+    fprintf(out, "#[Mean    = %12.3f, StdDeviation   = %12.3f]\n", mean / scale, sqrt(var / h->total) / scale);
+    fprintf(out, "#[Max     = %12.3f, Total count    = %12llu]\n", h->max / scale,
+            (unsigned long long)h->total);
+}
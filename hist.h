@@ -0,0 +1,45 @@
+/*
+ * hist.h - HDR маягийн хоцрогдлын гистограм
+ *
+ * Утгыг 2-ын зэргийн муж бүрт HIST_SUB_BITS-ийн нарийвчлалтай дэд
+ * бакетэд тоолно: 1-ээс 2^63 хүртэлх утгыг ~1.5%-ийн харьцангуй алдаатай,
+ * тогтмол хэмжээний массивт, бичих нь хуваах, салаалалтгүй хэдхэн заавар.
+ * Нэг эзэмшигч thread бичнэ. Бусад thread түгжээгүйгээр hist_merge-ээр
+ * өөрийн хуулбарт нэгтгэж уншина, бусад функц зөвхөн тэр хуулбар дээр.
+ */
+#ifndef __HIST_H__
+#define __HIST_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define HIST_SUB_BITS 7                 // Муж бүрийн дэд бакет 2^7, 2 оронгийн нарийвчлал
+#define HIST_SUB (1 << HIST_SUB_BITS)
+#define HIST_HALF (HIST_SUB / 2)
+#define HIST_BUCKETS ((64 - HIST_SUB_BITS + 2) * HIST_HALF)
+
+typedef struct {
+    uint64_t counts[HIST_BUCKETS];
+    uint64_t total;
+    uint64_t min, max;
+    uint64_t sum;
+} Hist;
+
+void hist_init(Hist *h);
+void hist_record(Hist *h, uint64_t v);
+void hist_merge(Hist *dst, const Hist *src);
+
+// p (0-100) хувийн утга, тэр бакетийн хамгийн их тэнцүү утгаар
+uint64_t hist_percentile(const Hist *h, double p);
+double hist_mean(const Hist *h);
+// v-ээс ихгүй утгын тоо (бакетын нарийвчлалаар), Prometheus-ийн le бакет
+uint64_t hist_count_le(const Hist *h, uint64_t v);
+
+/*
+ * hist_print - HdrHistogram-ийн "percentile distribution" хэлбэрээр хэвлэх
+ *     (Value, Percentile, TotalCount, 1/(1-Percentile)). Утгыг scale-д
+ *     хувааж хэвлэнэ, жишээ нь ns-ийг us болгоход 1000
+ */
+void hist_print(FILE *out, const Hist *h, double scale);
+
+#endif /* __HIST_H__ */
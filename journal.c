@@ -0,0 +1,129 @@
+/*
+ * journal.c - Тоглоомуудын нэмэгдэх хоёртын журнал
+ */
+#include "csapp.h"
+#include "journal.h"
+#include "log.h"
+#include <time.h>
+
+typedef struct JournalRing {
+    JournalRecord recs[JOURNAL_RING];
+    size_t head;                // Бичигч thread-ийн уншсан бичлэг
+    size_t tail;                // Эзэмшигч thread-ийн бичсэн бичлэг
+    unsigned long dropped;      // Цагираг дүүрч хаягдсан бичлэг
+    struct JournalRing *next;
+} JournalRing;
+
+static int journal_fd = -1;
+static uint64_t journal_epoch;  // Тоглоомын дугаарын дээд 32 бит
+static uint32_t journal_games;
+static JournalRing *rings;      // Бүх thread-ийн цагираг, зөвхөн нэмэгдэнэ
+static __thread JournalRing *my_ring;
+
+static JournalRing *journal_ring(void) {
+    if (!my_ring) {
+        JournalRing *r = Calloc(1, sizeof(JournalRing));
+        r->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&rings, &r->next, r, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+        my_ring = r;
+    }
+    return my_ring;
+}
+
+void journal_append(const JournalRecord *rec) {
+    JournalRing *r = journal_ring();
+
+    if (r->tail - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == JOURNAL_RING) {
+        __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    r->recs[r->tail & (JOURNAL_RING - 1)] = *rec;
+    __atomic_store_n(&r->tail, r->tail + 1, __ATOMIC_RELEASE);
+}
+
+static int journal_write(const void *buf, size_t len) {
+    const char *p = buf;
+    while (len) {
+        ssize_t n = write(journal_fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*
+ * Бичигч thread: бүх цагирагаас цуглуулсан багцыг нэг write-аар бичээд
+ * нэг fdatasync хийнэ. fsync-ийг хүлээх хооронд ирсэн бичлэгүүд дараагийн
+ * багцад орох тул ачаалал ихсэх тусам багц томорч fsync цөөрнө
+ */
+static void *journal_writer(void *vargp) {
+    static JournalRecord batch[JOURNAL_BATCH];
+    unsigned long reported = 0;
+
+    Pthread_detach(pthread_self());
+    while (1) {
+        size_t n = 0;
+        unsigned long dropped = 0;
+
+        for (JournalRing *r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+            size_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+            while (r->head != tail && n < JOURNAL_BATCH) {
+                batch[n++] = r->recs[r->head & (JOURNAL_RING - 1)];
+                __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+            }
+            dropped += __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+        }
+        if (dropped != reported) {
+            LOG(LOG_WARN, "journal: %lu records dropped\n", dropped - reported);
+            reported = dropped;
+        }
+
+        if (n) {
+            if (journal_write(batch, n * sizeof(JournalRecord)) < 0 || fdatasync(journal_fd) < 0)
+                LOG(LOG_ERROR, "journal write error: %s\n", strerror(errno));
+        } else {
+            struct timespec ts = {0, JOURNAL_IDLE_US * 1000};
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+void journal_open(const char *path) {
+    JournalHeader hdr;
+    struct stat st;
+    pthread_t tid;
+
+    journal_fd = Open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    Fstat(journal_fd, &st);
+    if (st.st_size == 0) {
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.magic = JOURNAL_MAGIC;
+        hdr.version = JOURNAL_VERSION;
+        hdr.record_size = sizeof(JournalRecord);
+        if (journal_write(&hdr, sizeof(hdr)) < 0)
+            unix_error("journal header write error");
+    } else {
+        if (pread(journal_fd, &hdr, sizeof(hdr), 0) != sizeof(hdr) || hdr.magic != JOURNAL_MAGIC ||
+            hdr.version != JOURNAL_VERSION || hdr.record_size != sizeof(JournalRecord))
+            app_error("journal: not a game journal");
+        // Унасан серверийн хагас бичигдсэн сүүлийн бичлэгийг хаяна
+        off_t whole = st.st_size - (st.st_size - sizeof(hdr)) % sizeof(JournalRecord);
+        if (whole != st.st_size && ftruncate(journal_fd, whole) < 0)
+            unix_error("journal truncate error");
+    }
+
+    journal_epoch = (uint64_t)time(NULL) << 32;
+    Pthread_create(&tid, NULL, journal_writer, NULL);
+}
+
+int journal_enabled(void) {
+    return journal_fd >= 0;
+}
+
+uint64_t journal_game_id(void) {
+    return journal_epoch | __atomic_add_fetch(&journal_games, 1, __ATOMIC_RELAXED);
+}
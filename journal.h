@@ -0,0 +1,59 @@
+/*
+ * journal.h - Тоглоомуудын нэмэгдэх хоёртын журнал
+ *
+ * Нүүдэл бүр (хүчингүй нь ч) цаг, оноо, шалгалтын үр дүнтэйгээ тогтмол
+ * 32 байтын бичлэг болно. Shard thread бүр өөрийн нэг бичигч, нэг
+ * уншигчтай цагирагт бичээд л буцна: тоглоомын давталт диск хүлээхгүй,
+ * цагираг дүүрвэл бичлэг хаягдаж тоологдоно. Арын нэг thread бүх
+ * цагирагийг нэг write-аар бичээд багц бүрт нэг fdatasync хийнэ (group
+ * commit). Файлыг replay хэрэгсэл Mmap хийж уншина.
+ */
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <stdint.h>
+
+#define JOURNAL_MAGIC 0x4e4a4f58u     // "XOJN"
+#define JOURNAL_VERSION 1
+#define JOURNAL_RING 4096             // Thread бүрийн бичлэг (2-ын зэрэг)
+#define JOURNAL_BATCH 8192            // Нэг write-ийн дээд бичлэг
+#define JOURNAL_IDLE_US 2000          // Хоосон үед бичигчийн хүлээх хугацаа
+
+// Бичлэгийн төрөл
+#define JOURNAL_START 1               // row = самбар (0 = хязгааргүй), col = win_len, score = AI суудал
+#define JOURNAL_MOVE 2                // score = board_analyze_position, info = суудал << 7 | MoveValidationResult
+#define JOURNAL_END 3                 // row = ялагч эсвэл GAMEOVER_DRAW, col = хугацаа нь дууссан суудал
+
+#define JOURNAL_SEAT(info) ((info) >> 7)
+#define JOURNAL_RESULT(info) ((info) & 0x7f)
+
+// Файлын эхэнд нэг удаа
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t pad;
+} JournalHeader;
+
+typedef struct {
+    uint64_t game;              // Серверийн эхэлсэн секунд << 32 | дугаар
+    int64_t time_us;            // CLOCK_REALTIME
+    int32_t row, col;
+    int32_t score;
+    uint16_t seq;               // Тоглоомын хийгдсэн нүүдлийн тоо
+    uint8_t type;
+    uint8_t info;
+} JournalRecord;
+
+/*
+ * journal_open - path-ийн төгсгөлд бичиж эхлэх, бичигч thread-ийг эхлүүлнэ
+ * journal_enabled - journal_open дуудагдсан эсэх
+ * journal_append - дуудсан thread-ийн цагирагт хуулна, хэзээ ч хүлээхгүй
+ * journal_game_id - шинэ тоглоомын дугаар
+ */
+void journal_open(const char *path);
+int journal_enabled(void);
+void journal_append(const JournalRecord *rec);
+uint64_t journal_game_id(void);
+
+#endif /* __JOURNAL_H__ */
@@ -0,0 +1,429 @@
+/*
+ * loadgen.c - Олон зэрэг тоглоом тоглуулах ачааллын клиент
+ *
+ * Нэг процесс, нэг epoll-оор -c ширхэг холболтыг зэрэг барина. Холболт бүр
+ * лоббиор хосолж (эсвэл -a үед AI-тай) тоглоод дуусмагц шинээр холбогдож,
+ * ачааллыг тогтмол байлгана. Холбогдох хурдыг -r-ээр, TURN ирснээс нүүх
+ * хүртэлх бодох хугацааг -t-ээр тохируулна. Нүүдлийг -S файлын дарааллаар
+ * (эзэлсэн нүдийг алгасаж), дууссан бол санамсаргүй хоосон нүдээр хийнэ.
+ *
+ * Хэмжилт: PLAY илгээснээс өөрийн MSG_MOVE буцаж иртэл (move RTT), connect()
+ * эхэлснээс WELCOME ирэх хүртэл (connect latency), хоёуланг hist-ээр.
+ */
+#include "csapp.h"
+#include "proto.h"
+#include "timer.h"
+#include "hist.h"
+#include <stdint.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <netinet/tcp.h>
+
+#define MAX_EVENTS 256
+#define RETRY_MS 1000           // Татгалзсан, тасарсан холболтыг дахин оролдох хүртэл
+#define REPORT_INTERVAL_MS 1000
+
+enum { P_IDLE, P_CONNECTING, P_HELLO, P_PLAYING };
+
+typedef struct Player {
+    int fd;
+    int state;
+    char symbol;                // SEAT ирэхээс өмнө 0
+    int pending;                // PLAY илгээгээд өөрийн MSG_MOVE-ийг хүлээж байна
+    int script_pos;
+    uint64_t sent_ns;           // PLAY эсвэл connect()-ийн хугацаа
+    Timer timer;                // Бодох хугацаа эсвэл дахин холбогдох
+    struct Player *next_idle;   // Холбогдох дараалал
+    int empties;
+    char *cells;                // size * size, ' ' = хоосон
+    char *in;
+    size_t inlen;
+} Player;
+
+typedef struct {
+    unsigned long connects, games, moves, rejected, errors, disconnects;
+} Counters;
+
+static int epfd, size = DEFAULT_BOARD_SIZE, win_len = DEFAULT_WIN_LENGTH;
+static uint32_t flags;
+static int think_ms, connect_rate;
+static size_t in_cap;
+static struct addrinfo *server_addr;
+static TimerWheel timers;
+static Player *idle_head, *idle_tail;
+static Timer pace_timer;
+static double pace_allowance;
+static int *script, script_len;  // row, col хосууд
+static Counters total;
+static Hist rtt_hist, connect_hist;
+static unsigned int seed = 1;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t now_ms(void) {
+    return now_ns() / 1000000;
+}
+
+static unsigned int next_rand(void) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void player_connect(Player *p);
+
+// Холбогдох ээлжинд оруулах. Хурдны хязгааргүй бол шууд холбогдоно
+static void player_queue(Player *p) {
+    p->state = P_IDLE;
+    if (!connect_rate) {
+        player_connect(p);
+        return;
+    }
+    p->next_idle = NULL;
+    if (idle_tail) idle_tail->next_idle = p;
+    else idle_head = p;
+    idle_tail = p;
+}
+
+static void player_retry(Timer *t) {
+    player_queue(timer_entry(t, Player, timer));
+}
+
+/*
+ * player_close - Холболтыг хаагаад дахин холбогдох. retry бол RETRY_MS
+ *     хүлээнэ: сервер татгалзаж байхад тасралтгүй холбогдохгүйн тулд
+ */
+static void player_close(Player *p, int retry) {
+    timer_cancel(&timers, &p->timer);
+    if (p->fd >= 0) Close(p->fd);
+    p->fd = -1;
+    p->state = P_IDLE;
+    if (retry) timer_add(&timers, &p->timer, timers.now + RETRY_MS, player_retry);
+    else player_queue(p);
+}
+
+static int player_write(Player *p, char type, const void *payload, size_t len) {
+    char frame[FRAME_HDR_SIZE + HELLO_MSG_SIZE];
+    memcpy(frame_init(frame, type, len), payload, len);
+    // Фрейм жижиг тул сокетийн буферт бүтнээрээ орно, эс бол холболт гацсан
+    if (write(p->fd, frame, FRAME_HDR_SIZE + len) != (ssize_t)(FRAME_HDR_SIZE + len)) {
+        total.errors++;
+        player_close(p, 1);
+        return -1;
+    }
+    return 0;
+}
+
+static void player_connect(Player *p) {
+    p->fd = socket(server_addr->ai_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (p->fd < 0) unix_error("socket error");
+    int one = 1;
+    setsockopt(p->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    p->sent_ns = now_ns();
+    if (connect(p->fd, server_addr->ai_addr, server_addr->ai_addrlen) < 0 && errno != EINPROGRESS) {
+        total.errors++;
+        player_close(p, 1);
+        return;
+    }
+    struct epoll_event ev = {.events = EPOLLOUT, .data.ptr = p};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, p->fd, &ev) < 0) unix_error("epoll_ctl error");
+    p->state = P_CONNECTING;
+    p->symbol = 0;
+    p->pending = 0;
+    p->script_pos = 0;
+    p->inlen = 0;
+}
+
+// Сокет бичигдэхүйц болоход холболт тогтсон эсэхийг шалгаад HELLO илгээнэ
+static void player_connected(Player *p) {
+    int err = 0;
+    socklen_t len = sizeof(err);
+    if (getsockopt(p->fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err) {
+        total.errors++;
+        player_close(p, 1);
+        return;
+    }
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = p};
+    if (epoll_ctl(epfd, EPOLL_CTL_MOD, p->fd, &ev) < 0) unix_error("epoll_ctl error");
+
+    char hello[HELLO_MSG_SIZE];
+    put_u32(hello, PROTO_VERSION);
+    put_u32(hello + 4, size);
+    put_u32(hello + 8, win_len);
+    put_u32(hello + 12, flags);
+    if (player_write(p, MSG_HELLO, hello, sizeof(hello)) == 0) p->state = P_HELLO;
+}
+
+// Скриптийн дараагийн хоосон нүд, дууссан бол санамсаргүй хоосон нүд
+static int pick_cell(Player *p) {
+    while (p->script_pos < script_len) {
+        int r = script[2 * p->script_pos], c = script[2 * p->script_pos + 1];
+        p->script_pos++;
+        if (r >= 0 && r < size && c >= 0 && c < size && p->cells[r * size + c] == ' ')
+            return r * size + c;
+    }
+    if (!p->empties) return -1;
+    int n = size * size, i = next_rand() % n;
+    while (p->cells[i] != ' ') i = (i + 1) % n;
+    return i;
+}
+
+static void player_move(Player *p) {
+    int cell = pick_cell(p);
+    if (cell < 0) return;
+    char move[8];
+    put_u32(move, cell / size);
+    put_u32(move + 4, cell % size);
+    p->sent_ns = now_ns();
+    if (player_write(p, MSG_PLAY, move, sizeof(move)) == 0) p->pending = 1;
+}
+
+static void player_think(Timer *t) {
+    player_move(timer_entry(t, Player, timer));
+}
+
+// Нэг фрейм боловсруулах. Холболт хаагдсан бол -1
+static int player_frame(Player *p, char type, const char *msg, size_t len) {
+    switch (type) {
+    case MSG_WELCOME:
+        if (len < WELCOME_MSG_SIZE) break;
+        hist_record(&connect_hist, now_ns() - p->sent_ns);
+        total.connects++;
+        p->state = P_PLAYING;
+        return 0;
+    case MSG_SEAT:
+        if (len != 1) break;
+        p->symbol = msg[0];
+        return 0;
+    case MSG_SESSION:
+    case MSG_ADVICE:
+        return 0;
+    case MSG_BOARD:
+        if (len != 4 + (size_t)size * size) break;
+        memcpy(p->cells, msg + 4, size * size);
+        p->empties = 0;
+        for (int i = 0; i < size * size; i++) p->empties += p->cells[i] == ' ';
+        return 0;
+    case MSG_MOVE: {
+        if (len != MOVE_MSG_SIZE) break;
+        int r = get_u32(msg + 4), c = get_u32(msg + 8);
+        if (r < 0 || r >= size || c < 0 || c >= size) break;
+        if (p->cells[r * size + c] == ' ') p->empties--;
+        p->cells[r * size + c] = msg[12];
+        if (msg[12] == p->symbol && p->pending) {
+            hist_record(&rtt_hist, now_ns() - p->sent_ns);
+            total.moves++;
+            p->pending = 0;
+        }
+        return 0;
+    }
+    case MSG_TURN:
+        // Хүлээж байхад дахин TURN ирвэл сервер нүүдлийг хүлээж аваагүй
+        if (p->pending) total.rejected++, p->pending = 0;
+        if (think_ms) {
+            int jitter = think_ms / 2;
+            int delay = think_ms - jitter + (jitter ? next_rand() % (2 * jitter + 1) : 0);
+            timer_add(&timers, &p->timer, timers.now + delay, player_think);
+        } else {
+            player_move(p);
+        }
+        return p->fd < 0 ? -1 : 0;
+    case MSG_GAMEOVER:
+        total.games++;
+        player_close(p, 0);
+        return -1;
+    case MSG_ERROR:
+        total.errors++;
+        if (total.errors == 1) fprintf(stderr, "loadgen: server error: %.*s\n", (int)len, msg);
+        player_close(p, 1);
+        return -1;
+    }
+    total.errors++;
+    player_close(p, 1);
+    return -1;
+}
+
+static void player_read(Player *p) {
+    while (1) {
+        ssize_t n = read(p->fd, p->in + p->inlen, in_cap - p->inlen);
+        if (n < 0 && errno == EAGAIN) return;
+        if (n <= 0) {
+            total.disconnects++;
+            player_close(p, 1);
+            return;
+        }
+        p->inlen += n;
+
+        size_t off = 0;
+        char type;
+        const char *msg;
+        size_t len;
+        ssize_t fl;
+        while ((fl = frame_parse(p->in + off, p->inlen - off, &type, &msg, &len)) > 0) {
+            off += fl;
+            if (player_frame(p, type, msg, len) < 0) return;
+        }
+        if (fl < 0 || (off == 0 && p->inlen == in_cap)) {
+            total.errors++;
+            player_close(p, 1);
+            return;
+        }
+        memmove(p->in, p->in + off, p->inlen - off);
+        p->inlen -= off;
+    }
+}
+
+// Миллисекунд бүр хурдны хязгаарт багтах тооны холболт нээнэ
+static void pace_tick(Timer *t) {
+    pace_allowance += connect_rate / 1000.0;
+    if (!idle_head && pace_allowance > 1) pace_allowance = 1;
+    while (idle_head && pace_allowance >= 1) {
+        Player *p = idle_head;
+        idle_head = p->next_idle;
+        if (!idle_head) idle_tail = NULL;
+        pace_allowance -= 1;
+        player_connect(p);
+    }
+    timer_add(&timers, t, timers.now + 1, pace_tick);
+}
+
+static void load_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) unix_error("loadgen: script");
+    int r, c, cap = 0;
+    while (fscanf(f, "%d %d", &r, &c) == 2) {
+        if (script_len == cap) script = Realloc(script, (cap = cap ? 2 * cap : 64) * 2 * sizeof(int));
+        script[2 * script_len] = r;
+        script[2 * script_len + 1] = c;
+        script_len++;
+    }
+    fclose(f);
+}
+
+static void print_latency(const char *name, const Hist *h) {
+    printf("%s (us): p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f  mean %.1f  (%llu samples)\n", name,
+           hist_percentile(h, 50) / 1e3, hist_percentile(h, 99) / 1e3, hist_percentile(h, 99.9) / 1e3,
+           h->max / 1e3, hist_mean(h) / 1e3, (unsigned long long)h->total);
+}
+
+int main(int argc, char **argv) {
+    int opt, conns = 100, duration = 10, histograms = 0;
+    connect_rate = 1000;
+    // -c: зэрэг холболт, -r: секундэд нээх холболт (0 = хязгааргүй),
+    // -t: бодох хугацаа мс (±50%), -d: ажиллах секунд, -a: AI-тай тоглох,
+    // -S: нүүдлийн скрипт (мөр бүрт "row col"), -H: бүтэн гистограм хэвлэх
+    while ((opt = getopt(argc, argv, "c:r:t:d:aS:H")) != -1) {
+        if (opt == 'c') conns = atoi(optarg);
+        else if (opt == 'r') connect_rate = atoi(optarg);
+        else if (opt == 't') think_ms = atoi(optarg);
+        else if (opt == 'd') duration = atoi(optarg);
+        else if (opt == 'a') flags |= HELLO_VS_AI;
+        else if (opt == 'S') load_script(optarg);
+        else if (opt == 'H') histograms = 1;
+        else argc = optind;
+    }
+    if (argc - optind < 2 || argc - optind > 4 || conns <= 0 || duration <= 0) {
+        fprintf(stderr, "Usage: %s [-c conns] [-r connects/s] [-t think_ms] [-d seconds] [-a] [-S script] [-H] "
+                "<host> <port> [board_size [win_length]]\n", argv[0]);
+        exit(0);
+    }
+    char *host = argv[optind], *port = argv[optind + 1];
+    if (argc - optind > 2) size = atoi(argv[optind + 2]);
+    if (argc - optind > 3) win_len = atoi(argv[optind + 3]);
+    if (size <= 0) app_error("loadgen: bounded boards only");
+    in_cap = FRAME_HDR_SIZE + 4 + (size_t)size * size + 256;
+    seed = (unsigned int)now_ns() | 1;
+
+    // Холболт бүрт нэг fd, зөөлөн хязгаарыг хатуу хүртэл өсгөнө
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+    Signal(SIGPIPE, SIG_IGN);
+
+    struct addrinfo hints = {.ai_socktype = SOCK_STREAM, .ai_flags = AI_NUMERICSERV | AI_ADDRCONFIG};
+    int rc = getaddrinfo(host, port, &hints, &server_addr);
+    if (rc != 0) {
+        fprintf(stderr, "loadgen: %s:%s: %s\n", host, port, gai_strerror(rc));
+        exit(1);
+    }
+
+    epfd = epoll_create1(0);
+    if (epfd < 0) unix_error("epoll_create1 error");
+    uint64_t start = now_ms(), end = start + duration * 1000ULL, next_report = start + REPORT_INTERVAL_MS;
+    timer_wheel_init(&timers, start);
+    hist_init(&rtt_hist);
+    hist_init(&connect_hist);
+
+    Player *players = Calloc(conns, sizeof(Player));
+    char *cells = Malloc((size_t)conns * size * size), *in = Malloc(conns * in_cap);
+    for (int i = 0; i < conns; i++) {
+        players[i].fd = -1;
+        players[i].cells = cells + (size_t)i * size * size;
+        players[i].in = in + i * in_cap;
+        player_queue(&players[i]);
+    }
+    if (connect_rate) timer_add(&timers, &pace_timer, start + 1, pace_tick);
+
+    printf("loadgen: %d connections to %s:%s, %dx%d win %d%s, think %d ms, %d connects/s\n",
+           conns, host, port, size, size, win_len, flags & HELLO_VS_AI ? " vs AI" : "",
+           think_ms, connect_rate);
+    struct epoll_event events[MAX_EVENTS];
+    Counters last = total;
+    uint64_t now;
+    while ((now = now_ms()) < end) {
+        int timeout = timer_next_timeout(&timers);
+        if (timeout < 0 || timeout > (int)(next_report - now)) timeout = next_report > now ? next_report - now : 0;
+        int n = epoll_wait(epfd, events, MAX_EVENTS, timeout);
+        if (n < 0 && errno != EINTR) unix_error("epoll_wait error");
+        for (int i = 0; i < n; i++) {
+            Player *p = events[i].data.ptr;
+            if (p->state == P_CONNECTING) player_connected(p);
+            else if (p->fd >= 0) player_read(p);
+        }
+        now = now_ms();
+        timer_advance(&timers, now);
+
+        if (now >= next_report) {
+            double secs = (now - next_report + REPORT_INTERVAL_MS) / 1000.0;
+            int open = 0;
+            for (int i = 0; i < conns; i++) open += players[i].state == P_PLAYING;
+            printf("%5.1fs  %d playing  %.0f connects/s  %.0f moves/s  %lu games  rtt p99 %.1f us\n",
+                   (now - start) / 1000.0, open, (total.connects - last.connects) / secs,
+                   (total.moves - last.moves) / secs, total.games, hist_percentile(&rtt_hist, 99) / 1e3);
+            fflush(stdout);
+            last = total;
+            next_report = now + REPORT_INTERVAL_MS;
+        }
+    }
+
+    double secs = (now - start) / 1000.0;
+    printf("\n%.1f s: %lu connects (%.0f/s), %lu games, %lu moves (%.0f moves/s)\n", secs, total.connects,
+           total.connects / secs, total.games, total.moves, total.moves / secs);
+    printf("%lu rejected moves, %lu errors, %lu disconnects\n", total.rejected, total.errors, total.disconnects);
+    print_latency("move rtt", &rtt_hist);
+    print_latency("connect", &connect_hist);
+    if (histograms) {
+        printf("\nmove rtt (us):\n");
+        hist_print(stdout, &rtt_hist, 1e3);
+        printf("\nconnect (us):\n");
+        hist_print(stdout, &connect_hist, 1e3);
+    }
+
+    for (int i = 0; i < conns; i++)
+        if (players[i].fd >= 0) Close(players[i].fd);
+    Free(players);
+    Free(cells);
+    Free(in);
+    Free(script);
+    freeaddrinfo(server_addr);
+    Close(epfd);
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*
+ * lobby.c - Тоглогчдыг хослуулах түгжээгүй лобби
+ */
+#include "csapp.h"
+#include "lobby.h"
+
+// state: key << 32 | gen << 16 | users. key 0 бол сул бакет.
+// users нь бакетыг ашиглаж буй thread-ийн тоо, gen нь эзлэх бүрт нэмэгдэж
+// сүүлчийн гарагчийн чөлөөлөх CAS-ийг (ABA) хамгаална
+typedef struct {
+    uint64_t state;
+    void *waiting;    // Хосоо хүлээж буй тоглогч
+} __attribute__((aligned(64))) LobbyBucket;
+
+#define BUCKET_KEY(w) ((uint32_t)((w) >> 32))
+#define BUCKET_USERS(w) ((w) & 0xffff)
+#define BUCKET_GEN(w) ((w) & 0xffff0000ULL)
+
+static LobbyBucket buckets[LOBBY_BUCKETS];
+static sem_t create_mutex;   // Нэг key-д хоёр бакет үүсэхээс сэргийлнэ
+
+void lobby_init(void) {
+    Sem_init(&create_mutex, 0, 1);
+}
+
+uint32_t lobby_key(int board_size, int win_len, int rating) {
+    // 0 утгыг сул бакетэд зориулж үлдээнэ
+    return ((uint32_t)(board_size & 0xfff) << 20 | (uint32_t)(win_len & 0xf) << 16 |
+            (uint32_t)(rating / LOBBY_RATING_BAND & 0x7fff)) + 1;
+}
+
+static LobbyBucket *bucket_at(uint32_t key, int i) {
+    uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+    return &buckets[((h >> 56) + i) & (LOBBY_BUCKETS - 1)];
+}
+
+// Бакет чөлөөлөгдөж болох тул сул слотоор зогсохгүй бүх дарааллыг шалгана
+static LobbyBucket *bucket_find(uint32_t key) {
+    for (int i = 0; i < LOBBY_BUCKETS; i++) {
+        LobbyBucket *b = bucket_at(key, i);
+        uint64_t w = __atomic_load_n(&b->state, __ATOMIC_ACQUIRE);
+        while (BUCKET_KEY(w) == key) {
+            if (__atomic_compare_exchange_n(&b->state, &w, w + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                return b;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * bucket_get - key-ийн бакетын users-ийг нэмж авах, байхгүй бол сул
+ *     слотыг эзлэх. Бүх слот эзлэгдсэн бол NULL. Үүсгэх нь ховор тул
+ *     зөвхөн түүнийг түгжээгээр дараалуулна
+ */
+static LobbyBucket *bucket_get(uint32_t key) {
+    LobbyBucket *b = bucket_find(key);
+    if (b) return b;
+
+    P(&create_mutex);
+    if (!(b = bucket_find(key))) {
+        for (int i = 0; i < LOBBY_BUCKETS && !b; i++) {
+            LobbyBucket *x = bucket_at(key, i);
+            uint64_t w = __atomic_load_n(&x->state, __ATOMIC_ACQUIRE);
+            while (!BUCKET_KEY(w)) {
+                uint64_t next = (uint64_t)key << 32 | BUCKET_GEN(w + 0x10000) | 1;
+                if (__atomic_compare_exchange_n(&x->state, &w, next, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                    b = x;
+                    break;
+                }
+            }
+        }
+    }
+    V(&create_mutex);
+    return b;
+}
+
+// users-ийг буулгах. Сүүлчийнх нь хүлээгч үлдээгүй бол бакетыг сул болгоно
+static void bucket_put(LobbyBucket *b) {
+    uint64_t w = __atomic_sub_fetch(&b->state, 1, __ATOMIC_ACQ_REL);
+    if (BUCKET_USERS(w) == 0 && !__atomic_load_n(&b->waiting, __ATOMIC_ACQUIRE))
+        // Энэ хооронд хэн нэг нь авсан бол gen, users өөрчлөгдөж CAS бүтэлгүйтнэ
+        __atomic_compare_exchange_n(&b->state, &w, BUCKET_GEN(w), 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+
+int lobby_pair(uint32_t key, void *self, void **partner) {
+    LobbyBucket *b = bucket_get(key);
+    if (!b) return -1;
+    void *cur = __atomic_load_n(&b->waiting, __ATOMIC_ACQUIRE);
+
+    for (;;) {
+        if (cur) {
+            // Хүлээж буй тоглогчийг авах
+            if (__atomic_compare_exchange_n(&b->waiting, &cur, NULL, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                break;
+        } else {
+            // Слот хоосон тул өөрөө хүлээнэ
+            if (__atomic_compare_exchange_n(&b->waiting, &cur, self, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                break;
+        }
+        // CAS бүтэлгүйтвэл cur шинэчлэгдсэн, дахин оролдоно
+    }
+    *partner = cur;
+    bucket_put(b);
+    return 0;
+}
+
+int lobby_leave(uint32_t key, void *self) {
+    LobbyBucket *b = bucket_find(key);
+    if (!b) return 0;
+    void *cur = self;
+    int left = __atomic_compare_exchange_n(&b->waiting, &cur, NULL, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    bucket_put(b);
+    return left;
+}
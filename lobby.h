@@ -0,0 +1,35 @@
+/*
+ * lobby.h - Тоглогчдыг хослуулах түгжээгүй лобби
+ *
+ * Бакет бүр (самбарын хэмжээ, ялах урт, рейтингийн түвшин) нэг л хүлээх слоттой.
+ * Шинэ тоглогч CAS-аар слотод орж хүлээнэ, эсвэл аль хэдийн хүлээж буй
+ * тоглогчийг CAS-аар авч хосолно. Ингэснээр хослол O(1), глобал түгжээгүй.
+ * Хүлээгчгүй, ашиглаж буй thread-гүй болсон бакет чөлөөлөгдөж дахин
+ * ашиглагдана. Зөвхөн шинэ бакет үүсгэх нь нэг түгжээгээр дараалалтай.
+ */
+#ifndef __LOBBY_H__
+#define __LOBBY_H__
+
+#include <stdint.h>
+
+#define LOBBY_BUCKETS 256       // Зэрэг ашиглагдах бакетийн дээд тоо (2-ын зэрэг)
+#define LOBBY_RATING_BAND 200   // Нэг бакетэд орох рейтингийн зай
+
+void lobby_init(void);
+uint32_t lobby_key(int board_size, int win_len, int rating);
+
+/*
+ * lobby_pair - key бакетэд хүлээж буй тоглогч байвал түүнийг *partner-т
+ *     авна. Байхгүй бол self-ийг хүлээлгэд үлдээж *partner = NULL.
+ *     Авсан заагчийн эзэмшил дуудсан thread-д шилжинэ. LOBBY_BUCKETS
+ *     өөр key зэрэг хүлээж байгаа бол -1, self хүлээлгэд ороогүй.
+ */
+int lobby_pair(uint32_t key, void *self, void **partner);
+
+/*
+ * lobby_leave - Хүлээж буй self-ийг бакетаас гаргах. Аль хэдийн хэн нэгэн
+ *     авсан бол 0: self-ийн эзэмшил тэр thread-д шилжсэн.
+ */
+int lobby_leave(uint32_t key, void *self);
+
+#endif /* __LOBBY_H__ */
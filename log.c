@@ -0,0 +1,143 @@
+/*
+ * log.c - Тоглоомын давталтыг хаахгүй асинхрон лог
+ */
+#include "csapp.h"
+#include "log.h"
+#include <stdint.h>
+#include <stdarg.h>
+#include <time.h>
+
+// Бичлэг: 2 байт урт, 1 байт түвшин, текст. Цагирагийн хилээр хуваагдаж болно
+#define LOG_REC_HDR 3
+
+typedef struct LogRing {
+    char data[LOG_RING_SIZE];
+    size_t head;                // Бичигч thread-ийн уншсан байрлал
+    size_t tail;                // Эзэмшигч thread-ийн бичсэн байрлал
+    unsigned long dropped;      // Буфер дүүрч хаягдсан бичлэг
+    struct LogRing *next;
+} LogRing;
+
+LogLevel log_level = LOG_INFO;
+
+static LogRing *rings;          // Бүх thread-ийн буфер, зөвхөн нэмэгдэнэ
+static __thread LogRing *my_ring;
+
+static LogRing *log_ring(void) {
+    if (!my_ring) {
+        LogRing *r = Calloc(1, sizeof(LogRing));
+        r->next = __atomic_load_n(&rings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&rings, &r->next, r, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+        my_ring = r;
+    }
+    return my_ring;
+}
+
+static void ring_put(LogRing *r, size_t pos, const void *src, size_t n) {
+    size_t off = pos & (LOG_RING_SIZE - 1), first = LOG_RING_SIZE - off < n ? LOG_RING_SIZE - off : n;
+    memcpy(r->data + off, src, first);
+    memcpy(r->data, (const char *)src + first, n - first);
+}
+
+static void ring_get(LogRing *r, size_t pos, void *dst, size_t n) {
+    size_t off = pos & (LOG_RING_SIZE - 1), first = LOG_RING_SIZE - off < n ? LOG_RING_SIZE - off : n;
+    memcpy(dst, r->data + off, first);
+    memcpy((char *)dst + first, r->data, n - first);
+}
+
+void log_write(LogLevel level, const char *fmt, ...) {
+    LogRing *r = log_ring();
+    char rec[LOG_REC_HDR + LOG_LINE_MAX];
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(rec + LOG_REC_HDR, LOG_LINE_MAX, fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if (n >= LOG_LINE_MAX) n = LOG_LINE_MAX - 1;
+    rec[0] = n >> 8;
+    rec[1] = n & 0xff;
+    rec[2] = level;
+
+    size_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    if (LOG_RING_SIZE - (r->tail - head) < LOG_REC_HDR + (size_t)n) {
+        __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    ring_put(r, r->tail, rec, LOG_REC_HDR + n);
+    __atomic_store_n(&r->tail, r->tail + LOG_REC_HDR + n, __ATOMIC_RELEASE);
+}
+
+static void log_emit(int fd, char *buf, size_t *len) {
+    size_t off = 0;
+    while (off < *len) {
+        ssize_t n = write(fd, buf + off, *len - off);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        off += n;
+    }
+    *len = 0;
+}
+
+/*
+ * Бичигч thread: буфер бүрийг хоосолж stdout, stderr тус бүрд цөөн write
+ * хийнэ. Нэг thread-ийн мөрүүд дарааллаа хадгална.
+ */
+static void *log_writer(void *vargp) {
+    static char out[2][64 * 1024];
+    size_t len[2] = {0, 0};
+    unsigned long reported = 0;
+
+    Pthread_detach(pthread_self());
+    while (1) {
+        int idle = 1;
+        unsigned long dropped = 0;
+
+        for (LogRing *r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+            size_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+            while (r->head != tail) {
+                unsigned char hdr[LOG_REC_HDR];
+                ring_get(r, r->head, hdr, LOG_REC_HDR);
+                size_t n = hdr[0] << 8 | hdr[1];
+                int err = hdr[2] >= LOG_WARN;
+                if (len[err] + n > sizeof(out[err]))
+                    log_emit(err ? STDERR_FILENO : STDOUT_FILENO, out[err], &len[err]);
+                ring_get(r, r->head + LOG_REC_HDR, out[err] + len[err], n);
+                len[err] += n;
+                __atomic_store_n(&r->head, r->head + LOG_REC_HDR + n, __ATOMIC_RELEASE);
+                idle = 0;
+            }
+            dropped += __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+        }
+        if (dropped != reported) {
+            if (sizeof(out[1]) - len[1] < 64)
+                log_emit(STDERR_FILENO, out[1], &len[1]);
+            len[1] += snprintf(out[1] + len[1], 64, "log: %lu messages dropped\n", dropped - reported);
+            reported = dropped;
+        }
+        log_emit(STDOUT_FILENO, out[0], &len[0]);
+        log_emit(STDERR_FILENO, out[1], &len[1]);
+
+        if (idle) {
+            struct timespec ts = {0, LOG_IDLE_US * 1000};
+            nanosleep(&ts, NULL);
+        }
+    }
+    return NULL;
+}
+
+void log_init(LogLevel level) {
+    pthread_t tid;
+    log_level = level;
+    Pthread_create(&tid, NULL, log_writer, NULL);
+}
+
+int log_level_parse(const char *name, LogLevel *level) {
+    if (!strcmp(name, "debug")) *level = LOG_DEBUG;
+    else if (!strcmp(name, "info")) *level = LOG_INFO;
+    else if (!strcmp(name, "warn")) *level = LOG_WARN;
+    else if (!strcmp(name, "error")) *level = LOG_ERROR;
+    else return -1;
+    return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * log.h - Тоглоомын давталтыг хаахгүй асинхрон лог
+ *
+ * Thread бүр өөрийн нэг бичигч, нэг уншигчтай цагираг буфертэй. Лог
+ * дуудалт мөрийг буферт форматлаад л буцна, stdout/stderr-т бичих ажлыг
+ * арын нэг thread хийнэ. Буфер дүүрвэл мессеж хаягдаж тоологдоно.
+ */
+#ifndef __LOG_H__
+#define __LOG_H__
+
+#include <stddef.h>
+
+#define LOG_RING_SIZE (256 * 1024)  // Thread бүрийн буфер (2-ын зэрэг)
+#define LOG_LINE_MAX 4096           // Нэг бичлэгийн дээд урт
+#define LOG_IDLE_US 1000            // Хоосон үед бичигчийн хүлээх хугацаа
+
+typedef enum {
+    LOG_DEBUG,     // Самбарын зураг гэх мэт их хэмжээний гаралт
+    LOG_INFO,
+    LOG_WARN,      // LOG_WARN ба түүнээс дээш stderr руу
+    LOG_ERROR
+} LogLevel;
+
+extern LogLevel log_level;
+
+#define log_enabled(level) ((level) >= log_level)
+
+// Түвшин хаалттай үед аргументуудыг ч тооцохгүй
+#define LOG(level, ...) \
+    do { if (log_enabled(level)) log_write(level, __VA_ARGS__); } while (0)
+
+void log_init(LogLevel level);
+void log_write(LogLevel level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+int log_level_parse(const char *name, LogLevel *level);
+
+#endif /* __LOG_H__ */
@@ -0,0 +1,380 @@
+/*
+ * mcts.c - Monte Carlo модны хайлт (том самбарт)
+ */
+#include "csapp.h"
+#include "mcts.h"
+#include "pattern.h"
+#include "vcf.h"
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+typedef struct MctsNode {
+    struct MctsNode *children;  // Өргөтгөсний дараа нийтлэгдэнэ (release)
+    int nchildren;
+    int cell;                   // Энд хүргэсэн нүүдэл
+    int visits;                 // Сонгогдох бүрт нэмэгдэнэ (virtual loss)
+    int score;                  // Энд нүүсэн тоглогчийн 2 * ялалт + тэнцээ
+    int expanding;              // Нэг л thread өргөтгөнө
+    int terminal;               // Энэ нүүдэл ялалт
+    float prior;                // Өргөтгөх үеийн эрэмбэ, 0..1
+} MctsNode;
+
+typedef struct MctsChunk {
+    struct MctsChunk *next;
+    int used;
+    MctsNode nodes[MCTS_CHUNK_NODES];
+} MctsChunk;
+
+// Бүх thread-ийн хуваалцах мод
+typedef struct {
+    MctsNode root;
+    char player;                // Үндсэнд нүүх тоглогч
+    long deadline;
+    int target;                 // Нийт playout, 0 = хязгааргүй
+    int playouts;
+    int chunks;                 // Энэ хайлтад авсан хэсгүүд
+    MctsChunk *chunk_list;
+    int max_depth;
+    const int *stop;
+} MctsTree;
+
+// Нэг thread-ийн хувийн төлөв
+typedef struct {
+    MctsTree *tree;
+    Board *b;
+    int n;
+    int *stones;                // Тавигдсан нүднүүд
+    int nstones;
+    uint32_t *mark;             // Өргөтгөхөд давхардал хасах
+    uint32_t stamp;
+    MctsChunk *chunk;           // Зангилаа хуваарилж буй хэсэг
+    uint32_t rng;
+} MctsWorker;
+
+// Нийтийн pool: хайлтуудын буцаасан хэсгүүд
+static MctsChunk *free_chunks;
+static sem_t pool_mutex;
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static void pool_init(void) {
+    Sem_init(&pool_mutex, 0, 1);
+}
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+static uint32_t xorshift32(uint32_t *x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+// Хайлтын хэсгийн хязгаарт хүрсэн бол NULL
+static MctsChunk *chunk_get(MctsTree *t) {
+    MctsChunk *c = NULL;
+
+    P(&pool_mutex);
+    if (t->chunks < MCTS_MAX_CHUNKS) {
+        t->chunks++;
+        if ((c = free_chunks)) free_chunks = c->next;
+        else c = Malloc(sizeof(MctsChunk));
+        c->used = 0;
+        c->next = t->chunk_list;
+        t->chunk_list = c;
+    }
+    V(&pool_mutex);
+    return c;
+}
+
+static void chunks_release(MctsTree *t) {
+    P(&pool_mutex);
+    while (t->chunk_list) {
+        MctsChunk *c = t->chunk_list;
+        t->chunk_list = c->next;
+        c->next = free_chunks;
+        free_chunks = c;
+    }
+    V(&pool_mutex);
+}
+
+static MctsNode *nodes_alloc(MctsWorker *w, int count) {
+    if (!w->chunk || w->chunk->used + count > MCTS_CHUNK_NODES) {
+        if (!(w->chunk = chunk_get(w->tree))) return NULL;
+    }
+    MctsNode *nodes = &w->chunk->nodes[w->chunk->used];
+    w->chunk->used += count;
+    return nodes;
+}
+
+static void worker_place(MctsWorker *w, int cell, char player) {
+    board_place(w->b, cell / w->n, cell % w->n, player);
+    w->stones[w->nstones++] = cell;
+}
+
+// Сүүлийн count чулууг авах
+static void worker_undo(MctsWorker *w, int count) {
+    while (count--) {
+        int cell = w->stones[--w->nstones];
+        board_undo(w->b, cell / w->n, cell % w->n);
+    }
+}
+
+/*
+ * Навчийг өргөтгөх: чулуунаас MCTS_RADIUS дотор байгаа нүднүүдээс өөрөө
+ * болон өрсөлдөгч тавихад үнэлгээ хамгийн их өөрчлөгдөх MCTS_MAX_CHILDREN-ийг
+ * эрэмбээр нь хүүхэд болгоно
+ */
+static void expand(MctsWorker *w, MctsNode *node, char player) {
+    Board *b = w->b;
+    const int n = w->n;
+    char opp = player == 'X' ? 'O' : 'X';
+    int cells[MCTS_MAX_CHILDREN], orders[MCTS_MAX_CHILDREN], count = 0;
+
+    if (++w->stamp == 0) {
+        memset(w->mark, 0, (size_t)n * n * sizeof(uint32_t));
+        w->stamp = 1;
+    }
+    for (int i = 0; i < w->nstones; i++) {
+        int r0 = w->stones[i] / n, c0 = w->stones[i] % n;
+        int r1 = r0 + MCTS_RADIUS < n ? r0 + MCTS_RADIUS : n - 1;
+        int c1 = c0 + MCTS_RADIUS < n ? c0 + MCTS_RADIUS : n - 1;
+        for (int r = r0 > MCTS_RADIUS ? r0 - MCTS_RADIUS : 0; r <= r1; r++) {
+            for (int c = c0 > MCTS_RADIUS ? c0 - MCTS_RADIUS : 0; c <= c1; c++) {
+                int cell = r * n + c;
+                if (w->mark[cell] == w->stamp || b->cells[cell] != ' ') continue;
+                w->mark[cell] = w->stamp;
+
+                int order = pattern_threat_gain(b, r, c, player) + pattern_threat_gain(b, r, c, opp);
+                if (count < MCTS_MAX_CHILDREN) count++;
+                else if (order <= orders[count - 1]) continue;
+                int j = count - 1;
+                while (j > 0 && orders[j - 1] < order) {
+                    cells[j] = cells[j - 1];
+                    orders[j] = orders[j - 1];
+                    j--;
+                }
+                cells[j] = cell;
+                orders[j] = order;
+            }
+        }
+    }
+
+    MctsNode *children = count ? nodes_alloc(w, count) : NULL;
+    if (!children) {
+        // Pool дууссан эсвэл нүүх нүдгүй: дахин оролдохгүй навч хэвээр
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        MctsNode *ch = &children[i];
+        memset(ch, 0, sizeof(*ch));
+        ch->cell = cells[i];
+        ch->terminal = board_check_win(b, cells[i] / n, cells[i] % n, player);
+        ch->prior = orders[0] > 0 ? (float)orders[i] / orders[0] : 0;
+    }
+    node->nchildren = count;
+    __atomic_store_n(&node->children, children, __ATOMIC_RELEASE);
+}
+
+// UCT ба загварын эрэмбэ (progressive bias). Ялах нүүдэл байвал шууд,
+// зочлоогүй хүүхдийг эрэмбээр нь эхэлж
+static MctsNode *select_child(MctsNode *node) {
+    MctsNode *children = __atomic_load_n(&node->children, __ATOMIC_ACQUIRE);
+    int parent = __atomic_load_n(&node->visits, __ATOMIC_RELAXED);
+    double log_parent = log(parent > 1 ? parent : 1);
+    MctsNode *best = &children[0];
+    double best_value = -1;
+
+    for (int i = 0; i < node->nchildren; i++) {
+        MctsNode *ch = &children[i];
+        if (ch->terminal) return ch;
+        int visits = __atomic_load_n(&ch->visits, __ATOMIC_RELAXED);
+        if (!visits) return ch;
+        int score = __atomic_load_n(&ch->score, __ATOMIC_RELAXED);
+        double value = score / (2.0 * visits) + MCTS_UCT_C * sqrt(log_parent / visits) +
+                       MCTS_BIAS * ch->prior / (visits + 1);
+        if (value > best_value) {
+            best_value = value;
+            best = ch;
+        }
+    }
+    return best;
+}
+
+/*
+ * Санамсаргүй playout: одоо байгаа чулуунаас MCTS_RADIUS дотор санамсаргүй
+ * нүд. Нүүдэл бүрийг board_check_win-ээр шалгана. Ялагч эсвэл ' ' (тэнцээ)
+ */
+static char playout(MctsWorker *w, char player) {
+    Board *b = w->b;
+    const int n = w->n, span = 2 * MCTS_RADIUS + 1;
+    int placed = 0;
+    char winner = ' ';
+
+    while (placed < MCTS_PLAYOUT_MOVES && !board_is_full(b)) {
+        int cell = -1;
+        for (int tries = 0; tries < 16 && cell < 0; tries++) {
+            uint32_t x = xorshift32(&w->rng);
+            int base = w->stones[x % w->nstones];
+            int r = base / n + (int)(x >> 8) % span - MCTS_RADIUS;
+            int c = base % n + (int)(x >> 16) % span - MCTS_RADIUS;
+            if (r >= 0 && r < n && c >= 0 && c < n && b->cells[r * n + c] == ' ')
+                cell = r * n + c;
+        }
+        if (cell < 0) break;  // Ойролцоо сул нүд олдсонгүй: тэнцээ гэж үзнэ
+        int win = board_check_win(b, cell / n, cell % n, player);
+        worker_place(w, cell, player);
+        placed++;
+        if (win) {
+            winner = player;
+            break;
+        }
+        player = player == 'X' ? 'O' : 'X';
+    }
+    worker_undo(w, placed);
+    return winner;
+}
+
+// Нэг давталт: сонгох, өргөтгөх, playout, буцааж оноо нэмэх
+static void iterate(MctsWorker *w) {
+    MctsTree *t = w->tree;
+    MctsNode *path[MCTS_PLAYOUT_MOVES + 1];
+    char movers[MCTS_PLAYOUT_MOVES + 1];
+    MctsNode *node = &t->root;
+    char player = t->player, winner = ' ';
+    int depth = 0;
+
+    __atomic_fetch_add(&node->visits, 1, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&node->children, __ATOMIC_ACQUIRE) && depth < MCTS_PLAYOUT_MOVES) {
+        MctsNode *ch = select_child(node);
+        __atomic_fetch_add(&ch->visits, 1, __ATOMIC_RELAXED);
+        worker_place(w, ch->cell, player);
+        path[++depth] = ch;
+        movers[depth] = player;
+        node = ch;
+        if (ch->terminal) {
+            winner = player;
+            break;
+        }
+        player = player == 'X' ? 'O' : 'X';
+    }
+
+    if (!node->terminal) {
+        // Хоёр дахь удаа хүрсэн навчийг өргөтгөнө
+        if (node->visits > 1 && !__atomic_exchange_n(&node->expanding, 1, __ATOMIC_ACQUIRE))
+            expand(w, node, player);
+        if (!board_is_full(w->b)) winner = playout(w, player);
+    }
+
+    for (int i = 1; i <= depth; i++) {
+        int gain = winner == ' ' ? 1 : winner == movers[i] ? 2 : 0;
+        if (gain) __atomic_fetch_add(&path[i]->score, gain, __ATOMIC_RELAXED);
+    }
+    worker_undo(w, depth);
+    if (depth > __atomic_load_n(&t->max_depth, __ATOMIC_RELAXED))
+        __atomic_store_n(&t->max_depth, depth, __ATOMIC_RELAXED);
+}
+
+static int tree_done(MctsTree *t, int playouts) {
+    if (__atomic_load_n(t->stop, __ATOMIC_RELAXED)) return 1;
+    if (t->target && __atomic_load_n(&t->playouts, __ATOMIC_RELAXED) >= t->target) return 1;
+    return (playouts & 63) == 0 && now_ms() >= t->deadline;
+}
+
+static int worker_run(MctsTree *t, Board *b, uint32_t seed) {
+    const int n = b->size;
+    MctsWorker w;
+    int done = 0;
+
+    memset(&w, 0, sizeof(w));
+    w.tree = t;
+    w.b = b;
+    w.n = n;
+    w.rng = seed | 1;
+    w.stones = Malloc((size_t)n * n * sizeof(int));
+    w.mark = Calloc((size_t)n * n, sizeof(uint32_t));
+    for (int cell = 0; cell < n * n; cell++)
+        if (b->cells[cell] != ' ') w.stones[w.nstones++] = cell;
+
+    while (!tree_done(t, done)) {
+        iterate(&w);
+        done++;
+        __atomic_fetch_add(&t->playouts, 1, __ATOMIC_RELAXED);
+    }
+    Free(w.stones);
+    Free(w.mark);
+    return done;
+}
+
+// Туслах thread: үндсэн хайлт зогсох хүртэл ижил модонд playout хийнэ
+static void mcts_help(AiJob *job) {
+    Board b;
+
+    ai_job_board(&b, job);
+    int done = worker_run(job->group->shared, &b, 0x9e3779b9u * job->helper);
+    __atomic_fetch_add(&job->group->nodes, done, __ATOMIC_RELAXED);
+    board_free(&b);
+}
+
+void mcts_search(Board *b, char player, int budget_ms, int threads, int playouts, AiMove *result) {
+    long start = now_ms();
+    AiGroup group;
+    MctsTree t;
+
+    Pthread_once(&pool_once, pool_init);
+    result->row = result->col = -1;
+    result->score = 0;
+    result->depth = 0;
+    result->nodes = 0;
+    if (!b->stones) {
+        result->row = result->col = b->size / 2;
+        result->elapsed_ms = 0;
+        return;
+    }
+    // Санамсаргүй playout хүчит дарааллыг амархан алгасна
+    VcfResult vcf;
+    if (vcf_search(b, player, AI_VCF_NODES, &vcf)) {
+        result->row = vcf.row;
+        result->col = vcf.col;
+        result->score = 1000;
+        result->nodes = vcf.nodes;
+        result->elapsed_ms = now_ms() - start;
+        return;
+    }
+
+    memset(&t, 0, sizeof(t));
+    t.player = player;
+    t.deadline = start + budget_ms;
+    t.target = playouts;
+    t.root.visits = 1;  // Эхний давталт үндсийг өргөтгөнө
+    t.stop = &group.stop;
+
+    ai_group_start(&group, b, player, budget_ms, threads, mcts_help, &t);
+    result->nodes = worker_run(&t, b, (uint32_t)start);
+    ai_group_finish(&group);
+    result->nodes += group.nodes;
+
+    // Хамгийн их зочилсон хүүхэд, ялах нүүдэл байвал тэр
+    MctsNode *best = NULL;
+    for (int i = 0; i < t.root.nchildren; i++) {
+        MctsNode *ch = &t.root.children[i];
+        if (ch->terminal) {
+            best = ch;
+            break;
+        }
+        if (!best || ch->visits > best->visits) best = ch;
+    }
+    if (best) {
+        result->row = best->cell / b->size;
+        result->col = best->cell % b->size;
+        result->score = best->visits ? best->score * 500L / best->visits : 0;
+    }
+    result->depth = t.max_depth;
+    chunks_release(&t);
+    result->elapsed_ms = now_ms() - start;
+}
@@ -0,0 +1,33 @@
+/*
+ * mcts.h - Monte Carlo модны хайлт (том самбарт)
+ *
+ * Салаалалт их том самбарт alpha-beta гүн хүрэхгүй тул мод нь UCT-ээр
+ * сонгож, навч бүрээс санамсаргүй тоглолт (playout) хийнэ. Playout нь
+ * bitboard дээр чулуунуудын ойролцоо тоглож, нүүдэл бүрийг board_check_win-
+ * ээр шалгана. Олон thread нэг модыг хуваалцаж, сонгосон замдаа virtual
+ * loss тавьж бие биенээсээ өөр салаа сонгоно. Зангилаанууд нь нийтийн
+ * pool-оос авсан том хэсгүүдээс (chunk) тасралтгүй хуваарилагдаж, хайлт
+ * дуусахад pool-д буцна: зангилаа бүрт malloc байхгүй.
+ */
+#ifndef __MCTS_H__
+#define __MCTS_H__
+
+#include "ai.h"
+
+#define MCTS_CHUNK_NODES 16384    // Pool-ийн нэг хэсгийн зангилаа
+#define MCTS_MAX_CHUNKS 64        // Нэг хайлтын дээд хэсэг (~1M зангилаа)
+#define MCTS_MAX_CHILDREN 24      // Өргөтгөхөд авах хамгийн сайн нүүдэл
+#define MCTS_RADIUS 2             // Чулуунаас энэ зайд л нүүдэл
+#define MCTS_PLAYOUT_MOVES 96     // Үүнээс урт playout тэнцээ
+#define MCTS_UCT_C 1.0            // Судлах коэффициент
+#define MCTS_BIAS 4.0             // Загварын эрэмбийн нөлөө, зочлолтоор буурна
+
+/*
+ * mcts_search - b дээр player-ийн нүүдлийг хайх. playouts > 0 бол нийт
+ *     тэр тооны playout хийгээд, эсвэл budget_ms дуусаад зогсоно. result-ийн
+ *     nodes нь playout-ийн тоо, depth нь модны хамгийн гүн, score нь
+ *     сонгосон нүүдлийн ялалтын хувь (промилль)
+ */
+void mcts_search(Board *b, char player, int budget_ms, int threads, int playouts, AiMove *result);
+
+#endif /* __MCTS_H__ */
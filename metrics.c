@@ -0,0 +1,112 @@
+/*
+ * metrics.c - Prometheus текст форматаар хэмжүүр гаргах HTTP порт
+ */
+#include "csapp.h"
+#include "metrics.h"
+#include "log.h"
+#include <stdarg.h>
+
+static int metrics_fd;
+static void (*metrics_render)(MetricsBuf *m);
+
+static void metrics_printf(MetricsBuf *m, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void metrics_printf(MetricsBuf *m, const char *fmt, ...) {
+    va_list ap;
+    while (1) {
+        va_start(ap, fmt);
+        int n = vsnprintf(m->data + m->len, m->cap - m->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if (m->len + n < m->cap) {
+            m->len += n;
+            return;
+        }
+        m->cap = m->cap * 2 + n;
+        m->data = Realloc(m->data, m->cap);
+    }
+}
+
+void metrics_family(MetricsBuf *m, const char *name, const char *type, const char *help) {
+    metrics_printf(m, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void metrics_value(MetricsBuf *m, const char *name, const char *labels, double v) {
+    if (labels) metrics_printf(m, "%s{%s} %.17g\n", name, labels, v);
+    else metrics_printf(m, "%s %.17g\n", name, v);
+}
+
+void metrics_histogram(MetricsBuf *m, const char *name, const char *labels, const Hist *h,
+                       double scale, const double *bounds, int nbounds) {
+    const char *sep = labels ? "," : "";
+    if (!labels) labels = "";
+    for (int i = 0; i < nbounds; i++)
+        metrics_printf(m, "%s_bucket{%s%sle=\"%g\"} %llu\n", name, labels, sep, bounds[i],
+                       (unsigned long long)hist_count_le(h, (uint64_t)(bounds[i] * scale)));
+    metrics_printf(m, "%s_bucket{%s%sle=\"+Inf\"} %llu\n", name, labels, sep, (unsigned long long)h->total);
+    if (*labels) {
+        metrics_printf(m, "%s_sum{%s} %.17g\n", name, labels, h->sum / scale);
+        metrics_printf(m, "%s_count{%s} %llu\n", name, labels, (unsigned long long)h->total);
+    } else {
+        metrics_printf(m, "%s_sum %.17g\n", name, h->sum / scale);
+        metrics_printf(m, "%s_count %llu\n", name, (unsigned long long)h->total);
+    }
+}
+
+// Нэг хүсэлтийг хариулах. Толгойн мөрүүдийг хоосон мөр хүртэл уншина
+static void metrics_serve(int connfd, MetricsBuf *m) {
+    rio_t rio;
+    char line[MAXLINE], method[16], path[MAXLINE];
+    struct timeval tv = {METRICS_TIMEOUT_MS / 1000, METRICS_TIMEOUT_MS % 1000 * 1000};
+
+    setsockopt(connfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(connfd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    rio_readinitb(&rio, connfd);
+    if (rio_readlineb(&rio, line, sizeof(line)) <= 0) return;
+    if (sscanf(line, "%15s %8191s", method, path) != 2) return;
+    ssize_t n;
+    while ((n = rio_readlineb(&rio, line, sizeof(line))) > 0 && strcmp(line, "\r\n") && strcmp(line, "\n"))
+        ;
+    if (n <= 0) return;
+
+    char hdr[256];
+    int len;
+    if (strcmp(method, "GET") || (strcmp(path, "/metrics") && strncmp(path, "/metrics?", 9))) {
+        static const char body[] = "Not Found: try /metrics\n";
+        len = sprintf(hdr, "HTTP/1.0 404 Not Found\r\nContent-Type: text/plain\r\n"
+                      "Content-Length: %zu\r\nConnection: close\r\n\r\n", sizeof(body) - 1);
+        if (rio_writen(connfd, hdr, len) == len) rio_writen(connfd, (void *)body, sizeof(body) - 1);
+        return;
+    }
+
+    m->len = 0;
+    metrics_render(m);
+    len = sprintf(hdr, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                  "Content-Length: %zu\r\nConnection: close\r\n\r\n", m->len);
+    if (rio_writen(connfd, hdr, len) == len) rio_writen(connfd, m->data, m->len);
+}
+
+static void *metrics_thread(void *vargp) {
+    MetricsBuf m = {Malloc(64 * 1024), 0, 64 * 1024};
+
+    Pthread_detach(pthread_self());
+    while (1) {
+        int connfd = accept(metrics_fd, NULL, NULL);
+        if (connfd < 0) {
+            if (errno != EINTR && errno != ECONNABORTED)
+                LOG(LOG_ERROR, "metrics accept error: %s\n", strerror(errno));
+            continue;
+        }
+        metrics_serve(connfd, &m);
+        close(connfd);
+    }
+    return NULL;
+}
+
+void metrics_start(char *host, char *port, void (*render)(MetricsBuf *m)) {
+    pthread_t tid;
+
+    metrics_render = render;
+    metrics_fd = Open_listenfd_host(host ? host : METRICS_HOST, port);
+    Pthread_create(&tid, NULL, metrics_thread, NULL);
+}
@@ -0,0 +1,40 @@
+/*
+ * metrics.h - Prometheus текст форматаар хэмжүүр гаргах HTTP порт
+ *
+ * Тоолуурууд нь эзэмшигч thread-үүддээ түгжээгүй хуримтлагдана. Энд
+ * зөвхөн scrape ирэх үед render callback-ийг дуудаж, тэдгээрийг
+ * нэгтгэсэн текстийг буцаана. Хүсэлтүүдийг нэг арын thread дарааллаар
+ * нь хариулна: тоглоомын thread-үүд огт оролцохгүй.
+ */
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <stddef.h>
+#include "hist.h"
+
+#define METRICS_TIMEOUT_MS 1000     // Хүсэлтээ дуусгаагүй клиентийг хаах хугацаа
+#define METRICS_HOST "127.0.0.1"    // Хаяг заагаагүй үед зөвхөн loopback дээр сонсоно
+
+typedef struct {
+    char *data;
+    size_t len, cap;
+} MetricsBuf;
+
+// # HELP, # TYPE мөрүүд. type нь "counter", "gauge", "histogram"
+void metrics_family(MetricsBuf *m, const char *name, const char *type, const char *help);
+
+// Нэг утга. labels нь хаалтгүй "phase=\"read\"" эсвэл NULL
+void metrics_value(MetricsBuf *m, const char *name, const char *labels, double v);
+
+/*
+ * metrics_histogram - h-ийн утгыг scale-д хувааж (ns-ийг секунд болгоход
+ *     1e9), bounds-ийн хил бүрийн хуримтлагдсан _bucket, _sum, _count
+ */
+void metrics_histogram(MetricsBuf *m, const char *name, const char *labels, const Hist *h,
+                       double scale, const double *bounds, int nbounds);
+
+// host:port дээр сонсож, GET /metrics бүрт render-ийг дуудах thread эхлүүлэх.
+// host нь NULL бол METRICS_HOST
+void metrics_start(char *host, char *port, void (*render)(MetricsBuf *m));
+
+#endif /* __METRICS_H__ */
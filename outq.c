@@ -0,0 +1,125 @@
+/*
+ * outq.c - Холболт бүрийн илгээх дараалал
+ */
+#include "csapp.h"
+#include "outq.h"
+#include <sys/uio.h>
+
+Buf *buf_new(size_t cap) {
+    Buf *b = Malloc(sizeof(Buf) + cap);
+    b->refs = 1;
+    b->len = 0;
+    b->cap = cap;
+    return b;
+}
+
+void buf_unref(Buf *b) {
+    if (--b->refs == 0) Free(b);
+}
+
+// Цагирагийг хоёр дахин томруулж, head-ийг 0 руу шилжүүлэх
+static void outq_grow(OutQueue *q) {
+    int slots = q->slots ? 2 * q->slots : OUTQ_MIN_SLOTS;
+    Buf **bufs = Malloc(slots * sizeof(Buf *));
+
+    for (int i = 0; i < q->count; i++)
+        bufs[i] = q->bufs[(q->head + i) % q->slots];
+    Free(q->bufs);
+    q->bufs = bufs;
+    q->slots = slots;
+    q->head = 0;
+}
+
+static void outq_append(OutQueue *q, Buf *b) {
+    if (q->count == q->slots) outq_grow(q);
+    q->bufs[(q->head + q->count) % q->slots] = b;
+    q->count++;
+}
+
+/*
+ * outq_reserve - Дарааллын төгсгөлд n байтын зай нөөцлөх. Сүүлийн буфер
+ *     зөвхөн энэ дарааллынх бөгөөд багтвал түүн дээр нэмнэ. Сүүлд нь
+ *     хуваалцах буфер байвал хувийн буфер ээлжлэн орох магадлалтай тул
+ *     шинэ буферийг фреймийн хэмжээгээр л авна.
+ */
+char *outq_reserve(OutQueue *q, size_t n) {
+    Buf *tail = q->count ? q->bufs[(q->head + q->count - 1) % q->slots] : NULL;
+
+    if (!tail || tail->refs != 1 || tail->cap - tail->len < n) {
+        size_t cap = tail && tail->refs != 1 ? n : OUTQ_CHUNK;
+        tail = buf_new(n > cap ? n : cap);
+        outq_append(q, tail);
+    }
+    char *p = tail->data + tail->len;
+    tail->len += n;
+    q->bytes += n;
+    return p;
+}
+
+/*
+ * outq_push - Бэлэн буферийг хуулахгүйгээр дараалалд нэмэх. Олон дараалал
+ *     нэг буферийг хуваалцаж, сүүлийнх нь илгээгээд чөлөөлнө.
+ */
+void outq_push(OutQueue *q, Buf *b) {
+    b->refs++;
+    outq_append(q, b);
+    q->bytes += b->len;
+}
+
+/*
+ * outq_flush - Дарааллыг writev-ээр илгээх. Нэг дуудлагад OUTQ_IOV хүртэл
+ *     буфер явуулж, бүтэн явсан бол дараагийн багцыг үргэлжлүүлнэ. Бүгд
+ *     явсан бол 0, сокет дүүрч үлдэгдэл байвал 1, алдаа бол -1.
+ */
+int outq_flush(OutQueue *q, int fd) {
+    while (q->count > 0) {
+        struct iovec iov[OUTQ_IOV];
+        int niov = q->count < OUTQ_IOV ? q->count : OUTQ_IOV;
+        size_t batch = 0;
+        for (int i = 0; i < niov; i++) {
+            Buf *b = q->bufs[(q->head + i) % q->slots];
+            size_t skip = i == 0 ? q->off : 0;
+            iov[i].iov_base = b->data + skip;
+            iov[i].iov_len = b->len - skip;
+            batch += iov[i].iov_len;
+        }
+
+        ssize_t n = writev(fd, iov, niov);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : -1;
+        }
+
+        q->bytes -= n;
+        int partial = (size_t)n < batch;
+        while (q->count > 0) {
+            Buf *b = q->bufs[q->head];
+            size_t left = b->len - q->off;
+            if ((size_t)n < left) {
+                q->off += n;
+                break;
+            }
+            n -= left;
+            q->off = 0;
+            q->head = (q->head + 1) % q->slots;
+            q->count--;
+            buf_unref(b);
+        }
+        if (partial) return 1;
+    }
+    return 0;
+}
+
+void outq_clear(OutQueue *q) {
+    while (q->count > 0) {
+        buf_unref(q->bufs[q->head]);
+        q->head = (q->head + 1) % q->slots;
+        q->count--;
+    }
+    Free(q->bufs);
+    q->bufs = NULL;
+    q->slots = 0;
+    q->head = 0;
+    q->off = 0;
+    q->bytes = 0;
+}
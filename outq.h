@@ -0,0 +1,43 @@
+/*
+ * outq.h - Холболт бүрийн илгээх дараалал
+ *
+ * Нэг tick-ийн туршид тухайн клиентэд очих бүх фрейм дараалалд
+ * хуримтлагдаж, tick-ийн төгсгөлд нэг writev-ээр илгээгдэнэ.
+ */
+#ifndef __OUTQ_H__
+#define __OUTQ_H__
+
+#include <stddef.h>
+
+#define OUTQ_IOV 64            // Нэг writev-ийн дээд iovec
+#define OUTQ_CHUNK 4096        // Шинэ буферийн анхны хэмжээ
+#define OUTQ_MIN_SLOTS 8       // Цагирагийн анхны багтаамж
+
+// Лавлагааны тоолууртай буфер
+typedef struct Buf {
+    int refs;
+    size_t len;
+    size_t cap;
+    char data[];
+} Buf;
+
+// Тэгээр дүүргэсэн бүтэц хоосон дараалал. Цагираг хэрэгцээгээр өснө:
+// хязгаарыг дуудагч нь bytes-ээр тавина
+typedef struct {
+    Buf **bufs;            // Цагираг дараалал
+    int slots;             // bufs-ийн багтаамж
+    int head;
+    int count;
+    size_t off;            // Эхний буферээс аль хэдийн илгээсэн байт
+    size_t bytes;          // Илгээгдээгүй нийт байт
+} OutQueue;
+
+Buf *buf_new(size_t cap);
+void buf_unref(Buf *b);
+
+char *outq_reserve(OutQueue *q, size_t n);
+void outq_push(OutQueue *q, Buf *b);
+int outq_flush(OutQueue *q, int fd);
+void outq_clear(OutQueue *q);
+
+#endif /* __OUTQ_H__ */
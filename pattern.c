@@ -0,0 +1,246 @@
+/*
+ * pattern.c - Хүснэгтэд суурилсан загвар үнэлгээ
+ */
+#include "csapp.h"
+#include "pattern.h"
+
+#define SEG_MAX 5                       // Нэг хайлтаар хамрах цонхны дээд тоо
+#define SEG_CELLS 10                    // Нэг хайлтын нүдний дээд тоо, 3^10 < 2^16
+
+// Нэг ялах уртын хүснэгтүүд. score[m], threat[m] нь m цонх, m + win_len - 1 нүд
+typedef struct {
+    int seg_max;                        // SEG_CELLS-д багтах цонхны тоо
+    uint16_t *score[SEG_MAX + 1];
+    int32_t *threat[SEG_MAX + 1];       // AI-ийн үнэлгээ
+} SegTables;
+
+static uint16_t base3[1 << SEG_CELLS];          // битийн маск -> 3-тын тоо (цифр 0/1)
+static SegTables tables[MAX_WIN_LENGTH + 1];
+static pthread_once_t pattern_once = PTHREAD_ONCE_INIT;
+
+// Нэг win_len нүдтэй цонхны оноо
+static int window_score(int p, int o, int win_len) {
+    int pc = __builtin_popcount(p), oc = __builtin_popcount(o);
+    int ec = win_len - pc - oc;
+
+    if (pc == win_len) return SCORE_FIVE;
+    if (pc == win_len - 1 && ec == 1) return SCORE_FOUR;
+    if (oc == win_len - 1 && ec == 1) return SCORE_BLOCK;
+    return 0;
+}
+
+// Нэг цонхны AI үнэлгээ: зөвхөн нэг талын чулуутай цонх тэр талд жинтэй.
+// Жин нь ялахад дутуу чулуугаар: дүүрсэн нь THREAT_FIVE, нэг дутуу нь THREAT_FOUR
+static int window_threat(int p, int o, int win_len) {
+    static const int weight[6] = {0, THREAT_ONE, THREAT_TWO, THREAT_THREE, THREAT_FOUR, THREAT_FIVE};
+    int pc = __builtin_popcount(p), oc = __builtin_popcount(o);
+
+    if (pc && oc) return 0;
+    int k = pc ? pc : oc;
+    int w = k ? weight[k + 5 - win_len < 1 ? 1 : k + 5 - win_len] : 0;
+    return pc ? w : -w;
+}
+
+static void build_tables(void) {
+    for (int mask = 0; mask < (1 << SEG_CELLS); mask++) {
+        int v = 0;
+        for (int i = SEG_CELLS - 1; i >= 0; i--)
+            v = v * 3 + ((mask >> i) & 1);
+        base3[mask] = v;
+    }
+
+    for (int len = MIN_WIN_LENGTH; len <= MAX_WIN_LENGTH; len++) {
+        SegTables *t = &tables[len];
+        int win = (1 << len) - 1;
+        t->seg_max = SEG_CELLS - len + 1 < SEG_MAX ? SEG_CELLS - len + 1 : SEG_MAX;
+        for (int m = 1; m <= t->seg_max; m++) {
+            int cells = m + len - 1, states = 1;
+            for (int i = 0; i < cells; i++) states *= 3;
+            t->score[m] = Malloc(states * sizeof(uint16_t));
+            t->threat[m] = Malloc(states * sizeof(int32_t));
+            for (int p = 0; p < (1 << cells); p++) {
+                for (int o = 0; o < (1 << cells); o++) {
+                    if (p & o) continue;
+                    int score = 0, threat = 0;
+                    for (int j = 0; j < m; j++) {
+                        score += window_score((p >> j) & win, (o >> j) & win, len);
+                        threat += window_threat((p >> j) & win, (o >> j) & win, len);
+                    }
+                    t->score[m][base3[p] + 2 * base3[o]] = score;
+                    t->threat[m][base3[p] + 2 * base3[o]] = threat;
+                }
+            }
+        }
+    }
+}
+
+void pattern_init(void) {
+    Pthread_once(&pattern_once, build_tables);
+}
+
+// Шугамын lo..hi битээс эхлэх цонхнуудын нийт оноо
+static int line_score(const SegTables *t, int len, const uint64_t *mine, const uint64_t *theirs, int lo, int hi) {
+    int score = 0;
+
+    while (lo <= hi) {
+        int m = hi - lo + 1 < t->seg_max ? hi - lo + 1 : t->seg_max;
+        int p = line_bits(mine, lo, m + len - 1), o = line_bits(theirs, lo, m + len - 1);
+        score += t->score[m][base3[p] + 2 * base3[o]];
+        lo += m;
+    }
+    return score;
+}
+
+static int line_threat(const SegTables *t, int len, const uint64_t *mine, const uint64_t *theirs, int lo, int hi) {
+    int score = 0;
+
+    while (lo <= hi) {
+        int m = hi - lo + 1 < t->seg_max ? hi - lo + 1 : t->seg_max;
+        int p = line_bits(mine, lo, m + len - 1), o = line_bits(theirs, lo, m + len - 1);
+        score += t->threat[m][base3[p] + 2 * base3[o]];
+        lo += m;
+    }
+    return score;
+}
+
+static int max_int(int a, int b) { return a > b ? a : b; }
+static int min_int(int a, int b) { return a < b ? a : b; }
+
+/*
+ * analyze_position-тэй яг ижил оноо: (row, col)-оос win_len - 1 хүртэл
+ * дээш, зүүн тийш шилжсэн эхлэлийн цэг бүрээс дөрвөн чиглэлийн win_len
+ * нүдтэй цонх. Цонхнууд нэг шугам дээр дараалсан эхлэлтэй тул шугам бүрт
+ * нэг хайлт.
+ */
+int pattern_analyze_position(Board *b, int row, int col, char player) {
+    BitPlane *me = &b->bits[player == 'O'], *op = &b->bits[player != 'O'];
+    const int n = b->size, w = b->words, len = b->win_len, r = len - 1;
+    const int last = n - len;  // Цонхны хамгийн сүүлийн эхлэл
+    const SegTables *t = &tables[len];
+    int score = 0;
+
+    pattern_init();
+
+    // Хэвтээ: мөр sr, багана sc-ээс эхлэх
+    for (int sr = max_int(row - r, 0); sr <= min_int(row, n - 1); sr++)
+        score += line_score(t, len, me->rows + sr * w, op->rows + sr * w,
+                            max_int(col - r, 0), min_int(col, last));
+
+    // Босоо: багана sc, мөр sr-ээс эхлэх
+    for (int sc = max_int(col - r, 0); sc <= min_int(col, n - 1); sc++)
+        score += line_score(t, len, me->cols + sc * w, op->cols + sc * w,
+                            max_int(row - r, 0), min_int(row, last));
+
+    // Диагональ: k = sr - sc, sr-ээс эхлэх
+    for (int k = row - col - r; k <= row - col + r; k++) {
+        int lo = max_int(max_int(row - r, col - r + k), max_int(0, k));
+        int hi = min_int(min_int(row, col + k), min_int(last, last + k));
+        if (lo > hi) continue;
+        int d = (k + n - 1) * w;
+        score += line_score(t, len, me->diags + d, op->diags + d, lo, hi);
+    }
+
+    // Эсрэг диагональ: s = sr + sc, (sr + i, sc - i) нүднүүд
+    for (int s = row + col - 2 * r; s <= row + col; s++) {
+        int lo = max_int(max_int(row - r, s - col), max_int(0, s - n + 1));
+        int hi = min_int(min_int(row, s - col + r), min_int(last, s - r));
+        if (lo > hi) continue;
+        score += line_score(t, len, me->antis + s * w, op->antis + s * w, lo, hi);
+    }
+    return score;
+}
+
+/*
+ * Самбар бүхэлдээ: бүх шугамын бүх win_len нүдтэй цонхны оноо. Хайлтын
+ * (AI) үнэлгээнд зориулсан
+ */
+int pattern_evaluate(Board *b, char player) {
+    BitPlane *me = &b->bits[player == 'O'], *op = &b->bits[player != 'O'];
+    const int n = b->size, w = b->words, len = b->win_len;
+    const int last = n - len;
+    const SegTables *t = &tables[len];
+    int score = 0;
+
+    pattern_init();
+
+    for (int i = 0; i < n; i++) {
+        score += line_score(t, len, me->rows + i * w, op->rows + i * w, 0, last);
+        score += line_score(t, len, me->cols + i * w, op->cols + i * w, 0, last);
+    }
+    for (int d = 0; d < BOARD_DIAGS(b); d++) {
+        // diags[d]: k = d - (N - 1), мөр max(0, k)..min(N - 1, N - 1 + k)
+        int k = d - (n - 1);
+        score += line_score(t, len, me->diags + d * w, op->diags + d * w, max_int(0, k), min_int(last, last + k));
+        // antis[d]: мөр max(0, d - N + 1)..min(N - 1, d)
+        score += line_score(t, len, me->antis + d * w, op->antis + d * w, max_int(0, d - n + 1),
+                            min_int(last, d - len + 1));
+    }
+    return score;
+}
+
+/*
+ * AI-ийн үнэлгээ: бүх win_len нүдтэй цонхны window_threat-ийн нийлбэр,
+ * player-ийн талаас. Зөвхөн BOARD_BITBOARD
+ */
+int pattern_threats(Board *b, char player) {
+    BitPlane *me = &b->bits[player == 'O'], *op = &b->bits[player != 'O'];
+    const int n = b->size, w = b->words, len = b->win_len;
+    const int last = n - len;
+    const SegTables *t = &tables[len];
+    int score = 0;
+
+    pattern_init();
+
+    for (int i = 0; i < n; i++) {
+        score += line_threat(t, len, me->rows + i * w, op->rows + i * w, 0, last);
+        score += line_threat(t, len, me->cols + i * w, op->cols + i * w, 0, last);
+    }
+    for (int d = 0; d < BOARD_DIAGS(b); d++) {
+        int k = d - (n - 1);
+        score += line_threat(t, len, me->diags + d * w, op->diags + d * w, max_int(0, k), min_int(last, last + k));
+        score += line_threat(t, len, me->antis + d * w, op->antis + d * w, max_int(0, d - n + 1),
+                             min_int(last, d - len + 1));
+    }
+    return score;
+}
+
+// Нэг шугамын lo..hi эхлэлтэй цонхнуудад bit-ийн нүдэнд чулуу нэмэхэд
+// line_threat-ийн өөрчлөлт. Цонх бүр bit-ийг хамардаг тул хайлт бүрт bit байна
+static int line_threat_gain(const SegTables *t, int len, const uint64_t *mine, const uint64_t *theirs,
+                            int lo, int hi, int bit) {
+    int gain = 0;
+
+    while (lo <= hi) {
+        int m = hi - lo + 1 < t->seg_max ? hi - lo + 1 : t->seg_max;
+        int p = line_bits(mine, lo, m + len - 1), o = line_bits(theirs, lo, m + len - 1);
+        int idx = base3[p] + 2 * base3[o];
+        gain += t->threat[m][idx + base3[1 << (bit - lo)]] - t->threat[m][idx];
+        lo += m;
+    }
+    return gain;
+}
+
+/*
+ * (row, col)-д player тавибал pattern_threats(b, player) хэрхэн өөрчлөгдөх.
+ * Зөвхөн тэр нүдийг хамарсан цонхнууд өөрчлөгдөх тул шугам бүрт нэг хайлт.
+ * Нүд хоосон байх ёстой. AI хайлт үнэлгээгээ үүгээр шинэчилж, хөдөлгөөнөө
+ * эрэмбэлнэ
+ */
+int pattern_threat_gain(Board *b, int row, int col, char player) {
+    BitPlane *me = &b->bits[player == 'O'], *op = &b->bits[player != 'O'];
+    const int n = b->size, w = b->words, len = b->win_len, r = len - 1;
+    const int last = n - len;
+    const SegTables *t = &tables[len];
+    int k = row - col, s = row + col;
+    int gain = 0;
+
+    gain += line_threat_gain(t, len, me->rows + row * w, op->rows + row * w,
+                             max_int(col - r, 0), min_int(col, last), col);
+    gain += line_threat_gain(t, len, me->cols + col * w, op->cols + col * w,
+                             max_int(row - r, 0), min_int(row, last), row);
+    gain += line_threat_gain(t, len, me->diags + (k + n - 1) * w, op->diags + (k + n - 1) * w,
+                             max_int(row - r, max_int(0, k)), min_int(row, min_int(last, last + k)), row);
+    gain += line_threat_gain(t, len, me->antis + s * w, op->antis + s * w,
+                             max_int(row - r, max_int(0, s - n + 1)), min_int(row, min_int(last, s - r)), row);
+    return gain;
+}
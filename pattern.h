@@ -0,0 +1,33 @@
+/*
+ * pattern.h - Хүснэгтэд суурилсан загвар үнэлгээ
+ *
+ * Шугам дээрх дараалсан m (1..5) цонхыг хамарсан m + win_len - 1 нүдийг
+ * тоглогчийн болон өрсөлдөгчийн битийн маскаас 3-тын тооллын индекс болгон
+ * хувиргаж, эхлэхэд нэг удаа бэлдсэн хүснэгтээс тэр m цонхны нийт оноог
+ * шууд авна. Цонх нь самбарын win_len урттай, ялах урт бүрт тусдаа хүснэгт.
+ */
+#ifndef __PATTERN_H__
+#define __PATTERN_H__
+
+#include "board.h"
+
+// Цонхны оноо (analyze_position-тэй ижил)
+#define SCORE_FIVE      1000  // Тоглогчийн win_len
+#define SCORE_FOUR      100   // Тоглогчийн win_len - 1 + 1 хоосон
+#define SCORE_BLOCK     50    // Өрсөлдөгчийн win_len - 1 + 1 хоосон
+
+// AI-ийн цонхны жин: цонхонд зөвхөн нэг талын k чулуу, win_len 5 үед.
+// Өөр уртад ялахад дутуу чулууны тоогоор ижил жин авна
+#define THREAT_ONE      1
+#define THREAT_TWO      16
+#define THREAT_THREE    256
+#define THREAT_FOUR     4096
+#define THREAT_FIVE     65536
+
+void pattern_init(void);
+int pattern_analyze_position(Board *b, int row, int col, char player);
+int pattern_evaluate(Board *b, char player);
+int pattern_threats(Board *b, char player);
+int pattern_threat_gain(Board *b, int row, int col, char player);
+
+#endif /* __PATTERN_H__ */
@@ -0,0 +1,76 @@
+/*
+ * proto.c - Сервер, клиентийн хоорондын мессежийн фрейм
+ */
+#include "csapp.h"
+#include "proto.h"
+
+void put_u32(char *p, uint32_t v) {
+    v = htonl(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+uint32_t get_u32(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return ntohl(v);
+}
+
+// Фреймийн толгойг бичээд өгөгдлийн байрлалыг буцаах
+char *frame_init(char *buf, char type, size_t payload_len) {
+    size_t body = payload_len + 1;
+    buf[0] = body >> 8;
+    buf[1] = body & 0xff;
+    buf[2] = type;
+    return buf + FRAME_HDR_SIZE;
+}
+
+/*
+ * frame_parse - buf-ийн эхэнд бүтэн фрейм байвал түүний нийт уртыг,
+ *     дутуу бол 0, буруу бол -1 буцаана. payload нь buf дотор заана.
+ */
+ssize_t frame_parse(const char *buf, size_t len, char *type, const char **payload, size_t *payload_len) {
+    if (len < FRAME_HDR_SIZE) return 0;
+    size_t body = (unsigned char)buf[0] << 8 | (unsigned char)buf[1];
+    if (body == 0) return -1;
+    if (len < 2 + body) return 0;
+    *type = buf[2];
+    *payload = buf + FRAME_HDR_SIZE;
+    *payload_len = body - 1;
+    return 2 + body;
+}
+
+/*
+ * read_frame - Блоклож нэг фрейм унших. Өгөгдлийн уртыг, EOF, сокетийн
+ *     алдаа эсвэл maxlen-ээс урт фрейм бол -1 буцаана.
+ */
+ssize_t read_frame(int fd, char *type, void *payload, size_t maxlen) {
+    char hdr[FRAME_HDR_SIZE];
+
+    if (rio_readn(fd, hdr, sizeof(hdr)) != sizeof(hdr)) return -1;
+    size_t body = (unsigned char)hdr[0] << 8 | (unsigned char)hdr[1];
+    if (body == 0 || body - 1 > maxlen) return -1;
+    *type = hdr[2];
+    if (rio_readn(fd, payload, body - 1) != (ssize_t)(body - 1)) return -1;
+    return body - 1;
+}
+
+/*
+ * write_frame - Фреймийг нэг write-аар илгээх. Холболт тасарсан бол -1:
+ *     Rio_writen шиг процессыг зогсоохгүй, дуудагч дахин холбогдож болно
+ */
+int write_frame(int fd, char type, const void *payload, size_t len) {
+    char buf[FRAME_HDR_SIZE + 64];
+    char *p = frame_init(buf, type, len);
+    ssize_t n;
+
+    if (len <= sizeof(buf) - FRAME_HDR_SIZE) {
+        memcpy(p, payload, len);
+        n = rio_writen(fd, buf, FRAME_HDR_SIZE + len);
+    } else {
+        char *big = Malloc(FRAME_HDR_SIZE + len);
+        memcpy(frame_init(big, type, len), payload, len);
+        n = rio_writen(fd, big, FRAME_HDR_SIZE + len);
+        Free(big);
+    }
+    return n == (ssize_t)(FRAME_HDR_SIZE + len) ? 0 : -1;
+}
@@ -0,0 +1,70 @@
+/*
+ * proto.h - Сервер, клиентийн хоорондын мессежийн фрейм
+ *
+ * Фрейм бүр: 2 байт урт (big-endian, төрөл + өгөгдөл), 1 байт төрөл, өгөгдөл.
+ * Бүх бүхэл тоо network byte order-оор.
+ */
+#ifndef __PROTO_H__
+#define __PROTO_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define FRAME_HDR_SIZE 3        // урт + төрөл
+#define FRAME_MAX_BODY 65535
+
+#define PROTO_VERSION 1
+#define DEFAULT_BOARD_SIZE 20
+#define DEFAULT_WIN_LENGTH 5
+
+// Сервер -> клиент
+#define MSG_WELCOME  'W'   // хувилбар, самбарын хэмжээ, ялах урт
+#define MSG_ERROR    'E'   // шалтгаан (текст), дараа нь холболт хаагдана
+#define MSG_SEAT     'S'   // тэмдэг (1 байт 'X' эсвэл 'O')
+#define MSG_BOARD    'B'   // seq, бүтэн самбар
+#define MSG_STONES   'L'   // seq, чулуу бүрийн row, col, тэмдэг (хязгааргүй самбар)
+#define MSG_MOVE     'M'   // seq, row, col, тэмдэг
+#define MSG_TURN     'T'   // таны ээлж
+#define MSG_GAMEOVER 'G'   // ялагчийн суудал эсвэл доорх утга
+#define MSG_ADVICE   'A'   // MSG_HINT-ийн хариу: row, col (-1 = хүчит ялалтгүй), нүүдлийн тоо, зангилаа
+#define MSG_SESSION  'K'   // MSG_SEAT-ийн дараа: дахин холбогдох token (u32 дээд, u32 доод)
+
+// Клиент -> сервер
+#define MSG_HELLO    'H'   // хувилбар, самбарын хэмжээ, ялах урт, туг (u32 бүр)
+#define MSG_PLAY     'P'   // row, col
+#define MSG_RESYNC   'R'   // бүтэн самбар дахин хүсэх
+#define MSG_HINT     'Q'   // өөрийн хүчит ялалтыг (VCF) асуух
+
+#define MOVE_MSG_SIZE (3 * 4 + 1)
+#define HELLO_MSG_SIZE (4 * 4)  // Хуучин хувилбарт мэдэгдэхгүй нэмэлт талбар байж болно
+#define HELLO_AI_THREADS 16     // Нэмэлт u32: AI-ийн хайлтын thread (HELLO_VS_AI), 0 = анхдагч
+#define HELLO_GAME 20           // Нэмэлт u32: үзэх тоглоом (HELLO_SPECTATE), 0 = сүүлд эхэлсэн
+#define HELLO_TOKEN 24          // Нэмэлт 2 x u32: MSG_SESSION-ий token (HELLO_RESUME)
+#define HELLO_LAST_SEQ 32       // Нэмэлт u32: клиентийн хамгийн сүүлд авсан seq (HELLO_RESUME)
+#define HELLO_RESUME_SIZE (HELLO_LAST_SEQ + 4)
+#define WELCOME_MSG_SIZE (3 * 4)
+#define STONE_SIZE (2 * 4 + 1)
+#define ADVICE_MSG_SIZE (4 * 4)
+#define SESSION_MSG_SIZE (2 * 4)
+
+// MSG_GAMEOVER-ийн тусгай утгууд
+#define GAMEOVER_DRAW    -1
+#define GAMEOVER_TIMEOUT -3     // Хүлээн авагчийн хугацаа дууссан
+
+// HELLO-ийн туг
+#define HELLO_UNBOUNDED 0x1     // Хязгааргүй самбар, хэмжээ 0 гэж хариулна
+#define HELLO_VS_AI     0x2     // Серверийн AI-тай O суудалд тоглох
+#define HELLO_SPECTATE  0x4     // Тоглохгүй, HELLO_GAME тоглоомыг үзэх. WELCOME-д тоглоомын самбар
+#define HELLO_RESUME    0x8     // Тасарсан тоглоомдоо буцаж орох: WELCOME, SEAT, алдсан нүүдлүүд
+                                // (эсвэл бүтэн самбар), ээлж бол TURN
+
+void put_u32(char *p, uint32_t v);
+uint32_t get_u32(const char *p);
+
+char *frame_init(char *buf, char type, size_t payload_len);
+ssize_t frame_parse(const char *buf, size_t len, char *type, const char **payload, size_t *payload_len);
+
+ssize_t read_frame(int fd, char *type, void *payload, size_t maxlen);
+int write_frame(int fd, char type, const void *payload, size_t len);
+
+#endif /* __PROTO_H__ */
@@ -0,0 +1,189 @@
+/*
+ * replay.c - Тоглоомын журналыг уншиж нэгтгэх, дахин тоглуулах
+ *
+ * Журналыг Mmap хийгээд бичлэгүүдийг дарааллаар нь нэг удаа гүйнэ.
+ * Тоглоомуудын бичлэгүүд холилдсон байх тул тоглоом бүрийн төлөвийг
+ * дугаараар нь хэш хүснэгтээс олно. -r үед нүүдэл бүрийг самбар дээр
+ * дахин тавьж, журналд бичигдсэн шалгалт, ялагчтай тулгана.
+ */
+#include "csapp.h"
+#include "journal.h"
+#include "board.h"
+#include "proto.h"
+#include <time.h>
+
+typedef struct {
+    uint64_t id;                // 0 = хоосон
+    int size, win_len;
+    int moves, invalid;
+    int last_winner;            // Ялсан нүүдлийн суудал эсвэл -1
+    Board *board;               // -r үед
+} GameState;
+
+typedef struct {
+    GameState *games;
+    size_t cap, count;
+} GameTable;
+
+static GameState *game_find(GameTable *t, uint64_t id, int create);
+
+static void table_grow(GameTable *t) {
+    GameState *old = t->games;
+    size_t cap = t->cap;
+
+    t->cap = cap ? cap * 2 : 4096;
+    t->games = Calloc(t->cap, sizeof(GameState));
+    t->count = 0;
+    for (size_t i = 0; i < cap; i++)
+        if (old[i].id) *game_find(t, old[i].id, 1) = old[i];
+    Free(old);
+}
+
+static GameState *game_find(GameTable *t, uint64_t id, int create) {
+    if (create && 2 * (t->count + 1) > t->cap) table_grow(t);
+    if (!t->cap) return NULL;
+    size_t mask = t->cap - 1;
+    for (size_t i = (id * 0x9e3779b97f4a7c15ULL) >> 20 & mask; ; i = (i + 1) & mask) {
+        if (t->games[i].id == id) return &t->games[i];
+        if (!t->games[i].id) {
+            if (!create) return NULL;
+            t->games[i].id = id;
+            t->count++;
+            return &t->games[i];
+        }
+    }
+}
+
+static void print_board(Board *b) {
+    for (int r = 0; r < b->size; r++) {
+        for (int c = 0; c < b->size; c++)
+            printf(" %c", b->cells[r * b->size + c] == ' ' ? '.' : b->cells[r * b->size + c]);
+        printf("\n");
+    }
+}
+
+static long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char **argv) {
+    int opt, verify = 0, list = 0;
+    uint64_t only = 0;
+    // -r: самбар дээр дахин тоглуулж шалгах, -l: дууссан тоглоом бүрийг хэвлэх,
+    // -g: нэг тоглоомын бичлэгүүдийг хэвлэх
+    while ((opt = getopt(argc, argv, "rlg:")) != -1) {
+        if (opt == 'r') verify = 1;
+        else if (opt == 'l') list = 1;
+        else if (opt == 'g') only = strtoull(optarg, NULL, 0), verify = 1;
+        else argc = 0;
+    }
+    if (argc - optind != 1) {
+        fprintf(stderr, "Usage: %s [-r] [-l] [-g game_id] <journal>\n", argv[0]);
+        exit(0);
+    }
+
+    long start = now_us();
+    struct stat st;
+    int fd = Open(argv[optind], O_RDONLY, 0);
+    Fstat(fd, &st);
+    if ((size_t)st.st_size < sizeof(JournalHeader))
+        app_error("replay: not a game journal");
+    char *map = Mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    Close(fd);
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+    const JournalHeader *hdr = (const JournalHeader *)map;
+    if (hdr->magic != JOURNAL_MAGIC || hdr->version != JOURNAL_VERSION || hdr->record_size != sizeof(JournalRecord))
+        app_error("replay: not a game journal");
+    const JournalRecord *recs = (const JournalRecord *)(hdr + 1);
+    size_t count = (st.st_size - sizeof(*hdr)) / sizeof(JournalRecord);
+
+    GameTable table = {NULL, 0, 0};
+    unsigned long started = 0, finished = 0, moves = 0, invalid = 0, mismatches = 0;
+    unsigned long wins[2] = {0, 0}, draws = 0, timeouts = 0;
+    char error_msg[100];
+
+    for (size_t i = 0; i < count; i++) {
+        const JournalRecord *r = &recs[i];
+        if (only && r->game != only) continue;
+        GameState *g = game_find(&table, r->game, r->type == JOURNAL_START);
+        if (only)
+            printf("%ld.%06ld seq %u type %d (%d, %d) score %d seat %d result %d\n",
+                   (long)(r->time_us / 1000000), (long)(r->time_us % 1000000), r->seq, r->type,
+                   r->row, r->col, r->score, JOURNAL_SEAT(r->info), JOURNAL_RESULT(r->info));
+        // Журнал эхлэхээс өмнө эхэлсэн тоглоомын бичлэг
+        if (!g) continue;
+
+        switch (r->type) {
+        case JOURNAL_START:
+            started++;
+            g->size = r->row;
+            g->win_len = r->col;
+            g->last_winner = -1;
+            if (verify) {
+                g->board = Malloc(sizeof(Board));
+                board_init(g->board, g->size ? BOARD_BITBOARD : BOARD_SPARSE, g->size, g->win_len);
+            }
+            break;
+        case JOURNAL_MOVE: {
+            int seat = JOURNAL_SEAT(r->info), result = JOURNAL_RESULT(r->info);
+            char player = seat ? 'O' : 'X';
+            if (result != MOVE_VALID) {
+                invalid++;
+                g->invalid++;
+            } else {
+                moves++;
+                g->moves++;
+            }
+            if (!g->board) break;
+            if ((int)board_validate_move(g->board, r->row, r->col, error_msg) != result) {
+                mismatches++;
+                break;
+            }
+            if (result != MOVE_VALID) break;
+            board_place(g->board, r->row, r->col, player);
+            if (board_check_win(g->board, r->row, r->col, player)) g->last_winner = seat;
+            break;
+        }
+        case JOURNAL_END:
+            finished++;
+            if (r->col >= 0) timeouts++;
+            if (r->row == GAMEOVER_DRAW) draws++;
+            else if (r->row == 0 || r->row == 1) wins[r->row]++;
+            // Хугацаа, тасралтаар дуусаагүй бол ялагч нь сүүлийн ялсан нүүдэлтэй таарна
+            if (g->board && g->last_winner >= 0 && g->last_winner != r->row) mismatches++;
+            if (list)
+                printf("game %#llx: %dx%d win %d, %d moves, %d invalid, winner %d\n",
+                       (unsigned long long)g->id, g->size, g->size, g->win_len, g->moves, g->invalid, r->row);
+            if (only && g->board && g->size) print_board(g->board);
+            if (g->board) {
+                board_free(g->board);
+                Free(g->board);
+                g->board = NULL;
+            }
+            break;
+        }
+    }
+
+    long elapsed = now_us() - start;
+    printf("%zu records, %lu games started, %lu finished (X %lu, O %lu, draws %lu, timeouts %lu)\n",
+           count, started, finished, wins[0], wins[1], draws, timeouts);
+    printf("%lu moves, %lu invalid, %.1f moves per game\n",
+           moves, invalid, started ? (double)moves / started : 0.0);
+    if (verify) printf("%lu replay mismatches\n", mismatches);
+    if (count)
+        printf("span %.1f s, scanned in %ld ms (%.1f M records/s)\n",
+               (recs[count - 1].time_us - recs[0].time_us) / 1e6, elapsed / 1000,
+               elapsed ? (double)count / elapsed : 0.0);
+
+    for (size_t i = 0; i < table.cap; i++)
+        if (table.games[i].board) {
+            board_free(table.games[i].board);
+            Free(table.games[i].board);
+        }
+    Free(table.games);
+    Munmap(map, st.st_size);
+    return mismatches != 0;
+}
@@ -1,332 +1,1626 @@
 #include "csapp.h"
+#include "board.h"
+#include "pattern.h"
+#include "lobby.h"
+#include "outq.h"
+#include "proto.h"
+#include "log.h"
+#include "timer.h"
+#include "ai.h"
+#include "vcf.h"
+#include "journal.h"
+#include "hist.h"
+#include "metrics.h"
 #include <stdint.h>
 #include <time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/random.h>
+#include <netinet/tcp.h>
 
-#define BOARD_SIZE 20
 #define ANSI_COLOR_RED     "\x1b[31m"
 #define ANSI_COLOR_GREEN   "\x1b[32m"
 #define ANSI_COLOR_BLUE    "\x1b[34m"
 #define ANSI_COLOR_YELLOW  "\x1b[33m"
 #define ANSI_COLOR_RESET   "\x1b[0m"
 #define MOVE_TIMEOUT 30  // нэг хөдөлгөөн хийх хугацаа
+#define GAME_CLOCK_MS (10 * 60 * 1000)  // Тоглогч бүрийн нийт бодох хугацаа
+#define HANDSHAKE_TIMEOUT_MS 10000      // HELLO ирэх хүртэл хүлээх
+#define MAX_EVENTS 256
+#define STATS_INTERVAL 10  // shard статистик хэвлэх давтамж (сек)
+#define OUTBUF_LIMIT (64 * 1024)  // Нэг клиентэд хуримтлагдах дээд хэмжээ
+#define INBUF_LIMIT 64    // Ээлжээ хүлээж буй оролтын дээд хэмжээ
+#define PRINT_RADIUS 10  // Хязгааргүй самбараас хэвлэх хүрээ
+#define AI_WORKERS 2      // AI хайлтын анхдагч thread-ийн тоо
+#define AI_BUDGET_MS 200  // AI-ийн нэг нүүдлийн анхдагч хугацаа
+#define HINT_VCF_NODES 50000  // Нэг зөвлөгөөний VCF хайлтын төсөв
+#define SPECTATOR_LIMIT (16 * 1024)  // Үзэгчийн хуримтлагдах дээд хэмжээ, хэтэрвэл snapshot руу
+#define SPECTATE_SNAPSHOT_MS 1000     // Хоцорсон үзэгчид snapshot илгээх давтамж
+#define RESUME_GRACE_MS 30000         // Тасарсан тоглогчийн суудлыг хадгалах хугацаа
+#define RESUME_MAX_REPLAY 64          // Үүнээс олон нүүдэл алдсан бол бүтэн самбар илгээнэ
+#define MCTS_MIN_SIZE 32  // Энэ хэмжээнээс эхлэн AI нь MCTS-ээр хайна
+
+// Нэг хөдөлгөөний боловсруулалтын үе шат, shard бүр тус бүрийн гистограмтай
+enum {
+    PHASE_READ,        // Сокетоос унших
+    PHASE_VALIDATE,
+    PHASE_ANALYZE,
+    PHASE_WIN_CHECK,   // Ялалт, тэнцээ
+    PHASE_BROADCAST,   // Тоглогч, үзэгчдийн дараалалд нэмэх
+    PHASE_COUNT
+};
 
 typedef struct {
     int score;
     int moves_made;
-    time_t last_move_time;
+    long clock_ms;         // Тоглолтод үлдсэн бодох хугацаа
 } PlayerStats;
 
-// check_win функцийн
-int check_win(char board[][BOARD_SIZE], int row, int col, char player);
-
 typedef struct {
-    int pattern[5][2];  // Төвтэй харьцуулсан  координатууд
-    int weight;         // Оноо авах загварын ж
-} Pattern;
-
-// Зөвхөн 5 дараалсан ялах загваруудыг тодорхойлох
-const Pattern WIN_PATTERNS[] = {
-    // Хэвтээ
-    {{{0,0}, {0,1}, {0,2}, {0,3}, {0,4}}, 100},
-    // Босоо
-    {{{0,0}, {1,0}, {2,0}, {3,0}, {4,0}}, 100},
-    // Диагональ (дээд зүүнээс доод баруун руу)
-    {{{0,0}, {1,1}, {2,2}, {3,3}, {4,4}}, 100},
-    // Диагональ (дээд баруунаас доод зүүн рүү)
-    {{{0,0}, {1,-1}, {2,-2}, {3,-3}, {4,-4}}, 100}
+    int row, col;
+} LoggedMove;
+
+typedef struct Game Game;
+typedef struct Shard Shard;
+
+// Нэг холболтын төлөв
+typedef struct Conn {
+    int fd;
+    Shard *shard;          // Холболтыг эзэмшигч reactor
+    Game *game;
+    int seat;              // 0 = X, 1 = O, -1 = үзэгч
+    int board_size;        // HELLO-оор тохирсон самбар, 0 = хязгааргүй
+    int win_len;
+    int ai_threads;        // AI-тай тоглоомын хайлтын thread
+    rio_t rio;             // Уншсан боловч боловсруулаагүй фреймүүд
+    OutQueue outq;         // Илгээгдээгүй фреймүүд
+    int want_out;          // EPOLLOUT хүлээж байгаа эсэх
+    long lobby_since_us;   // Лоббид орсон хугацаа
+    uint32_t lobby_key;    // Лоббид хүлээж байвал бакетын key, эсвэл 0
+    int hung;              // Хүлээж байхдаа тасарсан боловч хос нь аль хэдийн авсан
+    struct Conn *partner;  // Shard хооронд: энэ shard-д хүлээж буй өрсөлдөгч
+    Timer idle_timer;      // HELLO-гийн хугацаа
+    int closing;           // Үлдсэн өгөгдлөө илгээгээд хаагдана
+    int dead;              // Алдаа гарсан, энэ tick-ийн төгсгөлд хаагдана
+    int dirty;             // Энэ tick-д илгээх зүйлтэй
+    int lagging;           // Үзэгч: хоцорсон тул хөдөлгөөн биш snapshot авна
+    uint32_t watch;        // Shard хооронд шилжих үед зорьсон тоглоом
+    uint64_t token;        // HELLO_RESUME: буцаж орох суудлын token, эсвэл 0
+    uint32_t last_seq;     // HELLO_RESUME: клиентийн сүүлд авсан seq
+    struct Conn *next_dead;
+    struct Conn *next_dirty;
+    struct Conn *prev_spec, *next_spec;  // Тоглоомын үзэгчид, shard хооронд шилжихэд next_spec
+} Conn;
+
+// Нэг тоглоомын бүх төлөв. Тоглоом бүр бусдаасаа хамааралгүй
+struct Game {
+    Shard *shard;
+    Board board;
+    PlayerStats stats[2];
+    int current_player;
+    int move_analysis[2];  // Тоглогч бүрийн хөдөлгөөний чанар
+    uint32_t seq;          // Хийгдсэн хөдөлгөөний тоо, delta бүрт нэмэгдэнэ
+    Conn *players[2];
+    int game_over;
+    int winner;
+    int timed_out;         // Хугацаа нь дууссан тоглогч, эсвэл -1
+    Timer turn_timer;      // Одоогийн ээлжийн эцсийн хугацаа
+    long turn_start_ms;
+    int ai_seat;           // AI тоглож буй суудал, эсвэл -1
+    int ai_pending;        // Ажилчин thread дээр явж буй хайлт, AI-ийн нүүдэл ба зөвлөгөө
+    AiJob ai_job;
+    AiJob hints[2];        // Суудал бүрийн зөвлөгөөний VCF хайлт
+    int hint_pending[2];
+    uint32_t hint_seq[2];  // Хүссэн үеийн seq, хариу ирэхэд өөрчлөгдсөн бол хуучирсан
+    uint64_t id;           // Журнал дахь дугаар
+    uint32_t watch_id;     // Үзэгчдэд: shard << 24 | дугаар
+    Conn *spectators;
+    int nspectators;
+    Buf *snapshot;         // snapshot_seq үеийн самбарын фрейм, бүх хүлээн авагчид хуваалцана
+    uint32_t snapshot_seq;
+    Game *prev, *next;     // Shard-ийн тоглоомууд
+    uint64_t tokens[2];    // Суудал бүрийн дахин холбогдох token, shard-ийг агуулна
+    Timer away_timers[2];  // Тасарсан тоглогчийн буцаж ирэх хугацаа
+    LoggedMove *moves;     // moves[k] нь seq k + 1, X-ээс эхлэн ээлжилнэ
+    int moves_cap;
+    unsigned long bytes_sent;  // Тоглогч, үзэгчдэд илгээсэн нийт байт
 };
 
-// Загвар таних 
-int check_win_enhanced(char board[][BOARD_SIZE], int row, int col, char player) {
-    // Эхлээд анхны тодорхойлсон алгоритмыг ашиглан шууд ялалтыг шалгах
-    if (check_win(board, row, col, player)) return 1;
+// Shard бүрийн тоолуурууд. Зөвхөн эзэмшигч thread бичдэг тул түгжээгүй,
+// харин статистик хэвлэгч thread атомаар уншина
+typedef struct {
+    unsigned long conns_accepted;
+    unsigned long conns_active;
+    unsigned long games_started;
+    unsigned long games_active;
+    unsigned long games_finished;
+    unsigned long moves;
+    unsigned long pairs;          // Энэ shard дээр үүссэн хослолууд
+    unsigned long pair_wait_us;   // Хослолын нийт хүлээлт
+    unsigned long conn_errors;    // Сокетийн алдаагаар хаагдсан холболтууд
+    unsigned long forfeits;       // Өрсөлдөгч тасарсан тул шийдэгдсэн тоглоомууд
+    unsigned long ai_moves;
+    unsigned long ai_nodes;
+    unsigned long ai_book;        // Нээлтийн номноос хийсэн AI нүүдэл
+    unsigned long hints;
+    unsigned long hint_nodes;     // Зөвлөгөөний VCF хайлтын зангилаа
+    unsigned long hint_us;        // Тэдгээрийн нийт хугацаа
+    unsigned long spectators;     // Одоо үзэж буй
+    unsigned long spectator_lags; // Хоцорч snapshot руу шилжсэн
+    unsigned long resumes;        // Тасраад буцаж орсон тоглогчид
+    unsigned long resume_snapshots; // Тэднээс алдсан нүүдэл нь хэт олон байсан
+    unsigned long timeouts;       // Ээлжийн хугацаа дууссан тоглоомууд
+    unsigned long invalid_moves;
+    unsigned long bytes_sent;
+} ShardStats;
+
+#define STAT_ADD(s, field, n) \
+    __atomic_store_n(&(s)->stats.field, (s)->stats.field + (n), __ATOMIC_RELAXED)
+#define STAT_INC(s, field) STAT_ADD(s, field, 1)
+#define STAT_DEC(s, field) STAT_ADD(s, field, -1)
+#define STAT_READ(s, field) __atomic_load_n(&(s)->stats.field, __ATOMIC_RELAXED)
+#define STAT_SUM(field) stat_sum(offsetof(ShardStats, field))
+
+// Нэг reactor thread: өөрийн epoll, сонсох сокет болон тоглоомууд.
+// Тоглоом үүссэн shard-даа үлддэг тул тоглоомын төлөвт түгжээ хэрэггүй
+struct Shard {
+    int id;
+    int epfd;
+    int listenfd;
+    Conn *dead_conns;       // Хаагдахаар хүлээж буй холболтууд
+    Conn *dirty_conns;      // Энэ tick-ийн төгсгөлд илгээх холболтууд
+    TimerWheel timers;      // Ээлж, handshake-ийн хугацаанууд
+    AiJob *ai_done;         // Ажилчин thread-үүдийн дуусгасан хайлт (CAS стек)
+    Conn *arrivals;         // Бусад shard-аас энэ shard-ийн тоглоомд үзэх, буцаж орохоор ирсэн (CAS стек)
+    int wake_fd;            // Дээрх хоёрыг мэдэгдэх eventfd
+    Game *games;            // Энэ shard дээрх тоглоомууд
+    uint32_t game_count;
+    pthread_t tid;
+    ShardStats stats __attribute__((aligned(64)));
+    Hist phases[PHASE_COUNT];   // ns, stats-ийн адил зөвхөн энэ thread бичнэ
+    Hist game_bytes;            // Дууссан тоглоом бүрийн bytes_sent
+} __attribute__((aligned(64)));
+
+static Shard *shards;
+static int nshards = 1;
+static BoardEngine board_engine = BOARD_BITBOARD;
+static int ai_workers = AI_WORKERS;
+static int ai_budget_ms = AI_BUDGET_MS;
+static int ai_threads = 1;  // HELLO-д заагаагүй үеийн thread
+static int mcts_min_size = MCTS_MIN_SIZE;
+static int mcts_rate;       // Цөм бүрийн секундэд хийх playout, 0 = зөвхөн хугацаагаар
+static Book book;           // -o өгөөгүй бол map нь NULL
+static uint32_t featured_game;  // Үзэгч тоглоом заагаагүй үед, сүүлд эхэлсэн
+
+static long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static long now_ms(void) {
+    return now_us() / 1000;
+}
+
+static long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+// start-аас хойшхи хугацааг үе шатын гистограмд нэмээд одоогийн хугацааг буцаана
+static long phase_mark(Shard *s, int phase, long start) {
+    long now = now_ns();
+    hist_record(&s->phases[phase], now - start);
+    return now;
+}
+
+// Бүх shard-ийн тоолуурыг scrape-ийн үед л нэгтгэнэ
+static unsigned long stat_sum(size_t offset) {
+    unsigned long sum = 0;
+    for (int i = 0; i < nshards; i++)
+        sum += __atomic_load_n((unsigned long *)((char *)&shards[i].stats + offset), __ATOMIC_RELAXED);
+    return sum;
+}
+
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        return -1;
+    return 0;
+}
+
+// Холболтыг алдаатай гэж тэмдэглэх. Жинхэнэ хаалт tick-ийн төгсгөлд
+static void conn_fail(Conn *c) {
+    if (c->dead) return;
+    c->dead = 1;
+    c->next_dead = c->shard->dead_conns;
+    c->shard->dead_conns = c;
+}
+
+/*
+ * Сокетийн алдаа (ECONNRESET, EPIPE г.м.) зөвхөн тухайн холболтыг хаана.
+ * csapp-ийн wrapper-ууд шиг процессыг зогсоохгүй, тоолуурт бүртгэнэ
+ */
+static void conn_error(Conn *c, const char *what) {
+    if (c->dead) return;
+    LOG(LOG_WARN, "%s error on fd %d: %s\n", what, c->fd, strerror(errno));
+    STAT_INC(c->shard, conn_errors);
+    conn_fail(c);
+}
+
+static void conn_watch(Conn *c, uint32_t events) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = c;
+    if (epoll_ctl(c->shard->epfd, EPOLL_CTL_MOD, c->fd, &ev) < 0)
+        conn_error(c, "epoll_ctl");
+}
+
+static void conn_mark_dirty(Conn *c) {
+    if (c->dirty || c->dead) return;
+    c->dirty = 1;
+    c->next_dirty = c->shard->dirty_conns;
+    c->shard->dirty_conns = c;
+}
+
+// Фреймийг илгээх дараалалд нэмж өгөгдлийн байрлалыг буцаах. Бодит илгээлт
+// tick-ийн төгсгөлд нэг writev-ээр хийгдэнэ
+static char *conn_frame(Conn *c, char type, size_t payload_len) {
+    static __thread char scratch[FRAME_HDR_SIZE + FRAME_MAX_BODY];
+
+    // Удаан клиент санах ойг дүүргэхгүй байх
+    if (c->dead || c->outq.bytes + FRAME_HDR_SIZE + payload_len > OUTBUF_LIMIT) {
+        conn_fail(c);
+        return frame_init(scratch, type, payload_len);
+    }
+    conn_mark_dirty(c);
+    return frame_init(outq_reserve(&c->outq, FRAME_HDR_SIZE + payload_len), type, payload_len);
+}
+
+static void spectator_catchup(Timer *t);
+
+static void conn_flush(Conn *c) {
+    size_t pending = c->outq.bytes;
+    int rc = outq_flush(&c->outq, c->fd);
+
+    if (rc < 0) {
+        conn_error(c, "write");
+        return;
+    }
+    STAT_ADD(c->shard, bytes_sent, pending - c->outq.bytes);
+    if (c->game) c->game->bytes_sent += pending - c->outq.bytes;
+    // Хоцорсон үзэгчийн дараалал хоослогдмогц timer хүлээлгүй snapshot авна
+    if (c->lagging && c->game && !c->outq.bytes) {
+        timer_cancel(&c->shard->timers, &c->idle_timer);
+        spectator_catchup(&c->idle_timer);
+    }
+    if (rc == 0 && c->closing) {
+        conn_fail(c);
+        return;
+    }
+    if (rc != c->want_out) {
+        c->want_out = rc;
+        conn_watch(c, rc ? EPOLLIN | EPOLLOUT : EPOLLIN);
+    }
+}
+
+static void flush_dirty_conns(Shard *s) {
+    while (s->dirty_conns) {
+        Conn *c = s->dirty_conns;
+        s->dirty_conns = c->next_dirty;
+        c->dirty = 0;
+        if (!c->dead && !c->want_out) conn_flush(c);
+    }
+}
+
+// Бүх өгөгдлөө илгээсний дараа холболтыг хаах
+static void conn_finish(Conn *c) {
+    if (c->dead) return;
+    c->closing = 1;
+    conn_mark_dirty(c);
+}
+
+// Фреймийг олон хүлээн авагчид хуваалцах буферт нэг удаа бичих
+static Buf *frame_buf(char type, size_t payload_len, char **payload) {
+    Buf *b = buf_new(FRAME_HDR_SIZE + payload_len);
+    b->len = b->cap;
+    *payload = frame_init(b->data, type, payload_len);
+    return b;
+}
+
+// Хуваалцах буферийг хуулахгүйгээр илгээх дараалалд нэмэх
+static void conn_push(Conn *c, Buf *b) {
+    if (c->dead) return;
+    if (c->outq.bytes + b->len > OUTBUF_LIMIT) {
+        conn_fail(c);
+        return;
+    }
+    outq_push(&c->outq, b);
+    conn_mark_dirty(c);
+}
+
+// Бүтэн самбар: seq өөрчлөгдөх хүртэл нэг буферийг бүх хүсэгчид өгнө.
+// Хязгааргүй самбарт зөвхөн тавигдсан чулуунуудын жагсаалт
+static Buf *game_snapshot(Game *g) {
+    Board *b = &g->board;
+    char *p;
+
+    if (g->snapshot && g->snapshot_seq == g->seq) return g->snapshot;
+    if (g->snapshot) buf_unref(g->snapshot);
+    g->snapshot_seq = g->seq;
+    if (b->size) {
+        g->snapshot = frame_buf(MSG_BOARD, 4 + b->size * b->size, &p);
+        put_u32(p, g->seq);
+        board_snapshot(b, p + 4);
+        return g->snapshot;
+    }
+    g->snapshot = frame_buf(MSG_STONES, 4 + b->stones * STONE_SIZE, &p);
+    put_u32(p, g->seq);
+    p += 4;
+    for (int i = sparse_next(&b->sparse, 0); i >= 0; i = sparse_next(&b->sparse, i + 1)) {
+        SparseCell *s = &b->sparse.slots[i];
+        put_u32(p, s->row);
+        put_u32(p + 4, s->col);
+        p[8] = s->stone;
+        p += STONE_SIZE;
+    }
+    return g->snapshot;
+}
+
+// Тоглоом эхлэх болон клиент resync хүссэн үед л
+void send_board(Conn *c, Game *g) {
+    conn_push(c, game_snapshot(g));
+}
+
+// Том самбарын snapshot ганцаараа SPECTATOR_LIMIT-ээс их байж болох тул хоосон
+// дараалалд хэмжээнээс үл хамааран нэг фрейм авна
+static int spectator_fits(Conn *c, Buf *b) {
+    return !c->outq.bytes || c->outq.bytes + b->len <= SPECTATOR_LIMIT;
+}
+
+// Үзэгчийн дарааллын илгээгдээгүй байт SPECTATOR_LIMIT-ээс хэтэрвэл хөдөлгөөнүүдийг
+// хуримтлуулахгүй, дараалал нь суларсны дараа шинэ snapshot авна
+static void spectator_send(Conn *c, Buf *b) {
+    if (c->dead || c->lagging) return;
+    if (!spectator_fits(c, b)) {
+        c->lagging = 1;
+        STAT_INC(c->shard, spectator_lags);
+        timer_add(&c->shard->timers, &c->idle_timer, now_ms() + SPECTATE_SNAPSHOT_MS, spectator_catchup);
+        return;
+    }
+    outq_push(&c->outq, b);
+    conn_mark_dirty(c);
+}
+
+static void spectator_catchup(Timer *t) {
+    Conn *c = timer_entry(t, Conn, idle_timer);
+
+    if (c->dead) return;
+    Buf *snap = game_snapshot(c->game);
+    if (!spectator_fits(c, snap)) {
+        timer_add(&c->shard->timers, &c->idle_timer, now_ms() + SPECTATE_SNAPSHOT_MS, spectator_catchup);
+        return;
+    }
+    c->lagging = 0;
+    outq_push(&c->outq, snap);
+    conn_mark_dirty(c);
+}
+
+static void spectator_unlink(Game *g, Conn *c) {
+    if (c->prev_spec) c->prev_spec->next_spec = c->next_spec;
+    else g->spectators = c->next_spec;
+    if (c->next_spec) c->next_spec->prev_spec = c->prev_spec;
+    timer_cancel(&g->shard->timers, &c->idle_timer);
+    c->game = NULL;
+    g->nspectators--;
+    STAT_DEC(g->shard, spectators);
+}
+
+// Сүүлийн хөдөлгөөн (seq, row, col, тэмдэг)-ийг нэг удаа кодлоод
+// тоглогч, үзэгч бүрийн дараалалд ижил буферийг нэмнэ
+static void game_broadcast_move(Game *g, int row, int col) {
+    char *p;
+    Buf *b = frame_buf(MSG_MOVE, MOVE_MSG_SIZE, &p);
+
+    put_u32(p, g->seq);
+    put_u32(p + 4, row);
+    put_u32(p + 8, col);
+    p[12] = board_get(&g->board, row, col);
+    for (int i = 0; i < 2; i++)
+        if (g->players[i]) conn_push(g->players[i], b);
+    for (Conn *c = g->spectators; c; c = c->next_spec)
+        spectator_send(c, b);
+    buf_unref(b);
+}
+
+// Хүчит ялалтын хайлтын хариуг илгээх
+static void send_advice(Conn *c, const VcfResult *r) {
+    char *p = conn_frame(c, MSG_ADVICE, ADVICE_MSG_SIZE);
+    put_u32(p, r->row);
+    put_u32(p + 4, r->col);
+    put_u32(p + 8, r->length);
+    put_u32(p + 12, r->nodes);
+}
+
+// Самбарын зураг их хэмжээтэй тул зөвхөн LOG_DEBUG түвшинд, мөр мөрөөр логлоно
+void print_board(Board *b, PlayerStats *stats) {
+    if (!log_enabled(LOG_DEBUG)) return;
+
+    // Хязгааргүй самбарын хувьд сүүлийн хөдөлгөөний орчмыг л хэвлэнэ
+    int r0 = 0, c0 = 0, r1 = b->size - 1, c1 = b->size - 1;
+    if (!b->size) {
+        int cr = b->stones ? b->last_row : 0, cc = b->stones ? b->last_col : 0;
+        r0 = cr - PRINT_RADIUS;
+        r1 = cr + PRINT_RADIUS;
+        c0 = cc - PRINT_RADIUS;
+        c1 = cc + PRINT_RADIUS;
+    }
+
+    // XO самбарыг хэвлэх
+    char line[LOG_LINE_MAX];
+    int len = 0;
+    LOG(LOG_DEBUG, "\nCurrent Board State (Move #%d):\n", stats[0].moves_made + stats[1].moves_made);
+    LOG(LOG_DEBUG, "Scores - X: %d, O: %d\n", stats[0].score, stats[1].score);
+    len += sprintf(line, "  ");
+    for (int i = c0; i <= c1; i++) {
+        len += sprintf(line + len, "%2d ", i);
+    }
+    LOG(LOG_DEBUG, "%s\n", line);
     
-    // 5 дараалсан загваруудыг шалгах
-    for (int i = 0; i < sizeof(WIN_PATTERNS)/sizeof(Pattern); i++) {
-        int matches = 0;
-        
-        // Сүүлийн хөдөлгөөний эргэн тойронд бүх боломжит байрлалд загварыг шалгах
-        for (int start_row = row - 4; start_row <= row; start_row++) {
-            for (int start_col = col - 4; start_col <= col; start_col++) {
-                matches = 0;
-                
-                // Загвар дахь байрлал бүрийг шалгах
-                for (int p = 0; p < 5; p++) {
-                    int check_row = start_row + WIN_PATTERNS[i].pattern[p][0];
-                    int check_col = start_col + WIN_PATTERNS[i].pattern[p][1];
-                    
-                    if (check_row >= 0 && check_row < BOARD_SIZE && 
-                        check_col >= 0 && check_col < BOARD_SIZE) {
-                        if (board[check_row][check_col] == player) {
-                            matches++;
-                        }
-                    }
-                }
-                
-                // Хэрэв 5 таарч байвал ялах байрлал
-                if (matches == 5) {
-                    return 1;
-                }
+    for (int i = r0; i <= r1; i++) {
+        len = sprintf(line, "%2d ", i);
+        for (int j = c0; j <= c1; j++) {
+            char cell = board_get(b, i, j);
+            if (cell == 'X') {
+                len += sprintf(line + len, ANSI_COLOR_RED " X " ANSI_COLOR_RESET);
+            } else if (cell == 'O') {
+                len += sprintf(line + len, ANSI_COLOR_BLUE " O " ANSI_COLOR_RESET);
+            } else {
+                len += sprintf(line + len, " . ");
             }
         }
+        LOG(LOG_DEBUG, "%s\n", line);
     }
-    return 0;
+    LOG(LOG_DEBUG, "\n");
 }
 
-// хөдөлгөөний хүчинтэй эсэх
-typedef enum {
-    MOVE_VALID,
-    MOVE_OUT_OF_BOUNDS,
-    MOVE_OCCUPIED,
-    MOVE_INVALID
-} MoveValidationResult;
-
-MoveValidationResult validate_move_enhanced(char board[][BOARD_SIZE], int row, int col, char *error_msg) {
-    switch(1) {
-        case 1: // Хүрээг шалгах
-            if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
-                sprintf(error_msg, "Position (%d,%d) is out of bounds!", row, col);
-                return MOVE_OUT_OF_BOUNDS;
-            }
-            
-        case 2: // Аль хэдийн ашиглаглсан эсэх
-            if (board[row][col] != ' ') {
-                sprintf(error_msg, "Position (%d,%d) is already occupied!", row, col);
-                return MOVE_OCCUPIED;
+
+static void ai_job_done(AiJob *job);
+
+// AI-ийн ээлж бол хайлтыг ажилчин thread-д өгнө, хариу нь shard-д eventfd-ээр ирнэ
+static void game_prompt_turn(Game *g) {
+    if (g->current_player != g->ai_seat) {
+        // Тасарсан тоглогч буцаж орохдоо TURN авна
+        if (g->players[g->current_player])
+            conn_frame(g->players[g->current_player], MSG_TURN, 0);
+        return;
+    }
+    AiJob *job = &g->ai_job;
+    board_snapshot(&g->board, job->cells);
+    job->player = g->ai_seat ? 'O' : 'X';
+    job->budget_ms = ai_budget_ms;
+    job->done = ai_job_done;
+    job->arg = g;
+    g->ai_pending++;
+    ai_submit(job);
+}
+
+/*
+ * game_hint - Тоглогч одоо нүүвэл хүчээр ялах дараалал байгаа эсэхийг
+ *     ажилчин thread-д хайлгах. Зөвхөн өөрийн ээлжинд, нэг зэрэг нэгийг
+ *     хүлээн авч, бусдыг хариугүй хаяна. Хязгааргүй самбарт зөвлөгөө байхгүй
+ */
+static void game_hint(Game *g, Conn *c) {
+    static const VcfResult none = {-1, -1, 0, 0, 0, 0};
+    int seat = c->seat, n = g->board.size;
+
+    if (g->current_player != seat || g->hint_pending[seat]) return;
+    if (!n) {
+        send_advice(c, &none);
+        return;
+    }
+    AiJob *job = &g->hints[seat];
+    if (!job->cells) {
+        job->cells = Malloc((size_t)n * n);
+        job->size = n;
+        job->win_len = g->board.win_len;
+        job->threads = 1;
+        job->engine = AI_VCF;
+        job->playouts = HINT_VCF_NODES;
+    }
+    board_snapshot(&g->board, job->cells);
+    job->player = seat ? 'O' : 'X';
+    job->done = ai_job_done;
+    job->arg = g;
+    g->hint_pending[seat] = 1;
+    g->hint_seq[seat] = g->seq;
+    g->ai_pending++;
+    ai_submit(job);
+}
+
+static void game_timeout(Timer *t);
+
+// Ээлжийн хугацаа: нэг хөдөлгөөний хязгаар эсвэл үлдсэн цагийн аль бага нь.
+// Буруу хөдөлгөөн хийж дахин асуухад хугацаа шинэчлэгдэхгүй
+static void game_start_turn(Game *g) {
+    long budget = g->stats[g->current_player].clock_ms;
+    if (budget > MOVE_TIMEOUT * 1000L) budget = MOVE_TIMEOUT * 1000L;
+
+    print_board(&g->board, g->stats);
+    g->turn_start_ms = now_ms();
+    timer_add(&g->shard->timers, &g->turn_timer, g->turn_start_ms + budget, game_timeout);
+    game_prompt_turn(g);
+}
+
+static void game_print_stats(Game *g) {
+    // эцсийн тоглоомын статистик
+    LOG(LOG_INFO, "\nGame Statistics:\n"
+        "Player X: %d moves, Score: %d, Move Quality: %d\n"
+        "Player O: %d moves, Score: %d, Move Quality: %d\n",
+        g->stats[0].moves_made, g->stats[0].score, g->move_analysis[0],
+        g->stats[1].moves_made, g->stats[1].score, g->move_analysis[1]);
+    
+    // Хөдөлгөөний чанарын харьцуулалт
+    if (g->move_analysis[0] > g->move_analysis[1]) {
+        LOG(LOG_INFO, "Player X played more strategically (higher move quality)\n");
+    } else if (g->move_analysis[1] > g->move_analysis[0]) {
+        LOG(LOG_INFO, "Player O played more strategically (higher move quality)\n");
+    } else {
+        LOG(LOG_INFO, "Both players showed similar strategic play\n");
+    }
+}
+
+// Журнал идэвхтэй бол нэг бичлэг нэмэх
+static void game_journal(Game *g, int type, int row, int col, int score, int info) {
+    JournalRecord rec;
+    struct timespec ts;
+
+    if (!journal_enabled()) return;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    rec.game = g->id;
+    rec.time_us = ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+    rec.row = row;
+    rec.col = col;
+    rec.score = score;
+    rec.seq = g->seq;
+    rec.type = type;
+    rec.info = info;
+    journal_append(&rec);
+}
+
+static void game_end(Game *g) {
+    g->game_over = 1;
+    game_journal(g, JOURNAL_END, g->winner, g->timed_out, 0, 0);
+    timer_cancel(&g->shard->timers, &g->turn_timer);
+    timer_cancel(&g->shard->timers, &g->away_timers[0]);
+    timer_cancel(&g->shard->timers, &g->away_timers[1]);
+    STAT_INC(g->shard, games_finished);
+    for (int i = 0; i < 2; i++) {
+        if (!g->players[i]) continue;
+        // Хугацаа нь дууссан тоглогч ялагчийн оронд GAMEOVER_TIMEOUT авна
+        put_u32(conn_frame(g->players[i], MSG_GAMEOVER, 4), i == g->timed_out ? GAMEOVER_TIMEOUT : g->winner);
+        conn_finish(g->players[i]);
+    }
+    if (g->spectators) {
+        char *p;
+        Buf *b = frame_buf(MSG_GAMEOVER, 4, &p);
+        put_u32(p, g->winner);
+        while (g->spectators) {
+            Conn *c = g->spectators;
+            spectator_unlink(g, c);
+            if (!c->dead) {
+                outq_push(&c->outq, b);
+                conn_mark_dirty(c);
             }
-            
-        case 3: // Хүчинтэй
-            return MOVE_VALID;
-            
-        default:
-            return MOVE_INVALID;
+            conn_finish(c);
+        }
+        buf_unref(b);
     }
+    game_print_stats(g);
 }
 
-int analyze_position(char board[][BOARD_SIZE], int row, int col, char player) {
-    int score = 0;
-    char opponent = (player == 'X') ? 'O' : 'X';
+static void game_release(Game *g);
+
+// Ээлжийн хугацаа дуусахад timer wheel дуудна
+static void game_timeout(Timer *t) {
+    Game *g = timer_entry(t, Game, turn_timer);
+    int current_player = g->current_player;
+
+    LOG(LOG_INFO, "Player %c timed out!\n", current_player ? 'O' : 'X');
+    g->winner = !current_player;  // Бусад тоглогч хугацааны дагуу ялна
+    g->timed_out = current_player;
+    g->stats[!current_player].score += 1;
+    STAT_INC(g->shard, timeouts);
+    g->stats[current_player].clock_ms -= now_ms() - g->turn_start_ms;
+    game_end(g);
+    // Хугацаа нь дууссан тоглогч тасарсан байж болно
+    game_release(g);
+}
+
+static void game_handle_move(Game *g, int row, int col) {
+    Shard *s = g->shard;
+    int current_player = g->current_player;
+    char error_msg[100];
+
+    long t = now_ns();
+    MoveValidationResult validation_result = board_validate_move(&g->board, row, col, error_msg);
+    t = phase_mark(s, PHASE_VALIDATE, t);
+    if (validation_result != MOVE_VALID) {
+        STAT_INC(s, invalid_moves);
+        game_journal(g, JOURNAL_MOVE, row, col, 0, current_player << 7 | validation_result);
+        LOG(LOG_WARN, "Invalid move: %s\n", error_msg);
+        LOG(LOG_INFO, "Player %c made an invalid move at (%d,%d), please try again\n", 
+            current_player ? 'O' : 'X', row, col);
+        game_prompt_turn(g);
+        return;
+    }
+
+    // Хөдөлгөөнийг хийхээс өмнө шинжлэх
+    int move_score = board_analyze_position(&g->board, row, col, current_player ? 'O' : 'X');
+    phase_mark(s, PHASE_ANALYZE, t);
+    g->move_analysis[current_player] += move_score;
     
-    // Бүх загваруудыг шалгах
-    for (int i = 0; i < sizeof(WIN_PATTERNS)/sizeof(Pattern); i++) {
-        for (int start_row = row - 4; start_row <= row; start_row++) {
-            for (int start_col = col - 4; start_col <= col; start_col++) {
-                int player_count = 0;
-                int opponent_count = 0;
-                int empty_count = 0;
-                
-                // Загвар дахь хэсгүүдийг тоолох
-                for (int p = 0; p < 5; p++) {
-                    int check_row = start_row + WIN_PATTERNS[i].pattern[p][0];
-                    int check_col = start_col + WIN_PATTERNS[i].pattern[p][1];
-                    
-                    if (check_row >= 0 && check_row < BOARD_SIZE && 
-                        check_col >= 0 && check_col < BOARD_SIZE) {
-                        if (board[check_row][check_col] == player) {
-                            player_count++;
-                        } else if (board[check_row][check_col] == opponent) {
-                            opponent_count++;
-                        } else if (board[check_row][check_col] == ' ') {
-                            empty_count++;
-                        }
-                    }
+    // Хөдөлгөөнийг хийх
+    board_place(&g->board, row, col, current_player ? 'O' : 'X');
+    g->stats[current_player].moves_made++;
+    g->stats[current_player].clock_ms -= now_ms() - g->turn_start_ms;
+    g->seq++;
+    if (g->seq > (uint32_t)g->moves_cap) {
+        g->moves_cap = g->moves_cap ? 2 * g->moves_cap : 64;
+        g->moves = Realloc(g->moves, g->moves_cap * sizeof(LoggedMove));
+    }
+    g->moves[g->seq - 1] = (LoggedMove){row, col};
+    game_journal(g, JOURNAL_MOVE, row, col, move_score, current_player << 7 | MOVE_VALID);
+    t = now_ns();
+    game_broadcast_move(g, row, col);
+    phase_mark(s, PHASE_BROADCAST, t);
+
+    LOG(LOG_INFO, "Player %c made a move at position (%d, %d) with score %d\n", 
+        current_player ? 'O' : 'X', row, col, move_score);
+
+    t = now_ns();
+    int won = board_check_win(&g->board, row, col, current_player ? 'O' : 'X');
+    int full = !won && board_is_full(&g->board);
+    phase_mark(s, PHASE_WIN_CHECK, t);
+    STAT_INC(s, moves);
+    if (won) {
+        g->winner = current_player;
+        g->stats[current_player].score += 1;
+        LOG(LOG_INFO, "Player %c wins!\n", current_player ? 'O' : 'X');
+        game_end(g);
+        return;
+    }
+
+    if (full) {
+        g->winner = GAMEOVER_DRAW;
+        LOG(LOG_INFO, "Game ended in a draw!\n");
+        game_end(g);
+        return;
+    }
+
+    g->current_player = !current_player;
+    game_start_turn(g);
+}
+
+// o NULL бол O суудалд AI тоглоно
+static Game *game_create(Shard *s, Conn *x, Conn *o) {
+    Game *g = Calloc(1, sizeof(Game));
+    g->shard = s;
+    g->watch_id = (uint32_t)s->id << 24 | (++s->game_count & 0xffffff);
+    g->next = s->games;
+    if (s->games) s->games->prev = g;
+    s->games = g;
+    __atomic_store_n(&featured_game, g->watch_id, __ATOMIC_RELAXED);
+    board_init(&g->board, x->board_size ? board_engine : BOARD_SPARSE, x->board_size, x->win_len);
+    g->winner = GAMEOVER_DRAW;
+    g->timed_out = -1;
+    g->ai_seat = -1;
+    g->stats[0].clock_ms = g->stats[1].clock_ms = GAME_CLOCK_MS;
+    g->players[0] = x;
+    g->players[1] = o;
+    if (!o) {
+        g->ai_seat = 1;
+        g->ai_job.size = x->board_size;
+        g->ai_job.win_len = x->win_len;
+        g->ai_job.threads = x->ai_threads;
+        g->ai_job.book = book.map ? &book : NULL;
+        g->ai_job.engine = x->board_size >= mcts_min_size ? AI_MCTS : AI_ALPHABETA;
+        // CPU-г тоглоом бүрт тогтмол хуваарилах: хурдан машин ч энэ тооноос хэтрэхгүй
+        g->ai_job.playouts = (int)((long)mcts_rate * ai_budget_ms / 1000 * x->ai_threads);
+        g->ai_job.cells = Malloc((size_t)x->board_size * x->board_size);
+    }
+    for (int i = 0; i < 2; i++) {
+        Conn *c = g->players[i];
+        if (!c) continue;
+        c->game = g;
+        c->seat = i;
+        *conn_frame(c, MSG_SEAT, 1) = i ? 'O' : 'X';
+        // Дээд 32 бит нь watch_id тул дахин холбогдоход аль shard-д очихыг мэднэ
+        uint32_t secret;
+        if (getrandom(&secret, sizeof(secret), 0) != sizeof(secret))
+            secret = (uint32_t)now_us() ^ (uint32_t)(uintptr_t)c;
+        g->tokens[i] = (uint64_t)g->watch_id << 32 | secret;
+        char *p = conn_frame(c, MSG_SESSION, SESSION_MSG_SIZE);
+        put_u32(p, g->tokens[i] >> 32);
+        put_u32(p + 4, (uint32_t)g->tokens[i]);
+        send_board(c, g);
+    }
+    if (journal_enabled()) {
+        g->id = journal_game_id();
+        game_journal(g, JOURNAL_START, x->board_size, x->win_len, g->ai_seat, 0);
+    }
+    STAT_INC(s, games_started);
+    STAT_INC(s, games_active);
+    game_start_turn(g);
+    return g;
+}
+
+// Тоглогчид болон AI-ийн хайлт аль аль нь салсны дараа
+static void game_free(Game *g) {
+    Shard *s = g->shard;
+
+    if (g->prev) g->prev->next = g->next;
+    else s->games = g->next;
+    if (g->next) g->next->prev = g->prev;
+    if (g->snapshot) buf_unref(g->snapshot);
+    hist_record(&s->game_bytes, g->bytes_sent);
+    STAT_DEC(s, games_active);
+    board_free(&g->board);
+    Free(g->ai_job.cells);
+    Free(g->hints[0].cells);
+    Free(g->hints[1].cells);
+    Free(g->moves);
+    Free(g);
+}
+
+// Тоглоом дуусч, тоглогч, AI-ийн хайлт аль нь ч үлдээгүй бол чөлөөлөх
+static void game_release(Game *g) {
+    if (g->game_over && !g->players[0] && !g->players[1] && !g->ai_pending)
+        game_free(g);
+}
+
+// Тасарсан тоглогч RESUME_GRACE_MS дотор буцаж ирээгүй: өрсөлдөгч нь ялна
+static void game_abandon(Game *g, int seat) {
+    LOG(LOG_INFO, "Player %c did not come back, Player %c wins by forfeit\n",
+        seat ? 'O' : 'X', seat ? 'X' : 'O');
+    STAT_INC(g->shard, forfeits);
+    g->winner = !seat;
+    g->stats[!seat].score += 1;
+    game_end(g);
+    game_release(g);
+}
+
+static void game_away_x(Timer *t) {
+    game_abandon(timer_entry(t, Game, away_timers[0]), 0);
+}
+
+static void game_away_o(Timer *t) {
+    game_abandon(timer_entry(t, Game, away_timers[1]), 1);
+}
+
+// Өөр thread-ээс s-ийн epoll-ийг сэрээх
+static void shard_wake(Shard *s) {
+    uint64_t one = 1;
+
+    if (write(s->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        LOG(LOG_ERROR, "eventfd write error: %s\n", strerror(errno));
+}
+
+// Ажилчин thread дээр: дууссан хайлтыг тоглоомын shard-ийн стект хийж сэрээнэ
+static void ai_job_done(AiJob *job) {
+    Shard *s = ((Game *)job->arg)->shard;
+
+    job->next = __atomic_load_n(&s->ai_done, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&s->ai_done, &job->next, job, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    shard_wake(s);
+}
+
+// Shard дээр: зөвлөгөөний хариуг тоглогчид өгөх. Хайлт явах хооронд тоглогч
+// салсан, эсвэл самбар өөрчлөгдсөн бол хаяна
+static void hint_done(Game *g, AiJob *job) {
+    Shard *s = g->shard;
+    VcfResult *r = &job->vcf;
+    int seat = job->player == 'O';
+    Conn *c = g->players[seat];
+
+    g->hint_pending[seat] = 0;
+    STAT_INC(s, hints);
+    STAT_ADD(s, hint_nodes, r->nodes);
+    STAT_ADD(s, hint_us, r->elapsed_us);
+    LOG(LOG_INFO, "Hint for %c: %s in %lu nodes, %ld us (%lu knps)\n", job->player,
+        r->row >= 0 ? "forced win" : r->exhausted ? "budget exhausted" : "no forced win",
+        r->nodes, r->elapsed_us, r->elapsed_us ? r->nodes * 1000 / r->elapsed_us : 0);
+    if (!g->game_over && c && !c->dead && g->hint_seq[seat] == g->seq)
+        send_advice(c, r);
+    game_release(g);
+}
+
+// Shard дээр: дууссан хайлтуудын нүүдлийг хийх. Хайлт явж байхад тоглоом
+// дуусч, тоглогч нь салсан байж болно
+static void ai_drain(Shard *s) {
+    AiJob *job = __atomic_exchange_n(&s->ai_done, NULL, __ATOMIC_ACQUIRE);
+    while (job) {
+        AiJob *next = job->next;
+        Game *g = job->arg;
+        AiMove *m = &job->result;
+
+        g->ai_pending--;
+        if (job->engine == AI_VCF) {
+            hint_done(g, job);
+        } else if (g->game_over) {
+            game_release(g);
+        } else {
+            if (m->book)
+                LOG(LOG_INFO, "AI played book move (%d, %d) (depth %d, score %d)\n",
+                    m->row, m->col, m->depth, m->score);
+            else if (job->engine == AI_MCTS)
+                LOG(LOG_INFO, "MCTS ran %lu playouts in %ld ms on %d threads (%ld/s, depth %d, win %d/1000)\n",
+                    m->nodes, m->elapsed_ms, job->threads,
+                    m->elapsed_ms ? (long)(m->nodes * 1000 / m->elapsed_ms) : 0L, m->depth, m->score);
+            else
+                LOG(LOG_INFO, "AI searched depth %d, %lu nodes in %ld ms on %d threads (score %d)\n",
+                    m->depth, m->nodes, m->elapsed_ms, job->threads, m->score);
+            STAT_INC(s, ai_moves);
+            STAT_ADD(s, ai_nodes, m->nodes);
+            STAT_ADD(s, ai_book, m->book);
+            game_handle_move(g, m->row, m->col);
+            // Хүн тоглогч тасарсан үед AI ялж болно
+            game_release(g);
+        }
+        job = next;
+    }
+}
+
+// Шинэ болон лоббигоос авсан холболтыг энэ shard-ийн epoll-д бүртгэх
+static int conn_adopt(Shard *s, Conn *c) {
+    struct epoll_event ev;
+    c->shard = s;
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, c->fd, &ev) < 0) {
+        LOG(LOG_WARN, "epoll_ctl error on fd %d: %s\n", c->fd, strerror(errno));
+        STAT_INC(s, conn_errors);
+        return -1;
+    }
+    STAT_INC(s, conns_active);
+    return 0;
+}
+
+// conn_adopt-ийн эсрэг: лоббид шилжих холболтыг shard-аас салгах
+static void conn_release(Shard *s, Conn *c) {
+    epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    STAT_DEC(s, conns_active);
+}
+
+// Аль ч shard-д бүртгэлгүй холболтыг хаах
+static void conn_drop(Conn *c) {
+    close(c->fd);
+    outq_clear(&c->outq);
+    Free(c);
+}
+
+static int lobby_enter(Shard *s, Conn *c);
+static void lobby_match(Shard *s, Conn *x, Conn *c);
+
+// Шалтгааныг илгээгээд холболтыг хаах
+static void conn_reject(Conn *c, const char *reason) {
+    size_t len = strlen(reason);
+    memcpy(conn_frame(c, MSG_ERROR, len), reason, len);
+    conn_finish(c);
+}
+
+// Энэ shard дээрх тоглоомд үзэгч нэмэх: WELCOME-д тоглоомын самбар, дараа нь snapshot
+static void spectator_join(Shard *s, Conn *c) {
+    Game *g = s->games;
+
+    while (g && g->watch_id != c->watch) g = g->next;
+    if (!g || g->game_over) {
+        conn_reject(c, "no such game");
+        return;
+    }
+    c->game = g;
+    c->seat = -1;
+    c->prev_spec = NULL;
+    c->next_spec = g->spectators;
+    if (g->spectators) g->spectators->prev_spec = c;
+    g->spectators = c;
+    g->nspectators++;
+    STAT_INC(s, spectators);
+
+    char *p = conn_frame(c, MSG_WELCOME, WELCOME_MSG_SIZE);
+    put_u32(p, PROTO_VERSION);
+    put_u32(p + 4, g->board.size);
+    put_u32(p + 8, g->board.win_len);
+    send_board(c, g);
+    LOG(LOG_DEBUG, "Spectator joined game %u (%d watching)\n", g->watch_id, g->nspectators);
+}
+
+/*
+ * Тасарсан тоглогчийг token-оор нь суудалд нь буцаах. Нэг хариугаар:
+ * WELCOME, SEAT, алдсан нүүдлүүд (move log-оос), олон бол бүтэн самбар,
+ * ээлж нь бол TURN. Хуучин холболт нь хагас нээлттэй үлдсэн бол түүнийг хаана
+ */
+static void session_resume(Shard *s, Conn *c) {
+    Game *g = s->games;
+
+    while (g && g->watch_id != c->watch) g = g->next;
+    int seat = !g ? -1 : c->token == g->tokens[0] ? 0 : c->token == g->tokens[1] ? 1 : -1;
+    if (seat < 0 || seat == g->ai_seat || g->game_over) {
+        conn_reject(c, "session expired");
+        return;
+    }
+    Conn *old = g->players[seat];
+    if (old) {
+        old->game = NULL;
+        conn_fail(old);
+    }
+    timer_cancel(&s->timers, &g->away_timers[seat]);
+    g->players[seat] = c;
+    c->game = g;
+    c->seat = seat;
+    STAT_INC(s, resumes);
+
+    char *p = conn_frame(c, MSG_WELCOME, WELCOME_MSG_SIZE);
+    put_u32(p, PROTO_VERSION);
+    put_u32(p + 4, g->board.size);
+    put_u32(p + 8, g->board.win_len);
+    *conn_frame(c, MSG_SEAT, 1) = seat ? 'O' : 'X';
+    uint32_t missed = g->seq - c->last_seq;
+    if (c->last_seq > g->seq || missed > RESUME_MAX_REPLAY) {
+        STAT_INC(s, resume_snapshots);
+        send_board(c, g);
+    } else {
+        for (uint32_t k = c->last_seq; k < g->seq; k++) {
+            p = conn_frame(c, MSG_MOVE, MOVE_MSG_SIZE);
+            put_u32(p, k + 1);
+            put_u32(p + 4, g->moves[k].row);
+            put_u32(p + 8, g->moves[k].col);
+            p[12] = k % 2 ? 'O' : 'X';
+        }
+    }
+    if (g->current_player == seat) conn_frame(c, MSG_TURN, 0);
+    LOG(LOG_INFO, "Player %c resumed game %u after seq %u (%s)\n", seat ? 'O' : 'X', g->watch_id,
+        c->last_seq, missed > RESUME_MAX_REPLAY || c->last_seq > g->seq ? "snapshot" : "replayed moves");
+}
+
+// Бусад shard-аас шилжиж ирсэн үзэгч, буцаж орох тоглогчдыг авах
+static void arrivals_drain(Shard *s) {
+    Conn *c = __atomic_exchange_n(&s->arrivals, NULL, __ATOMIC_ACQUIRE);
+
+    while (c) {
+        Conn *next = c->next_spec;
+        Conn *x = c->partner;
+        c->partner = NULL;
+        if (conn_adopt(s, c) < 0) {
+            conn_drop(c);
+            // Хүлээгч өөр өрсөлдөгч хайна. Энэ shard дээр хосолж болох тул
+            // зөвхөн тасралт ажиглаж байсан бүртгэлийг нь сэргээнэ
+            if (x) {
+                x->lobby_key = 0;
+                if (x->hung) conn_drop(x);
+                else {
+                    conn_watch(x, EPOLLIN);
+                    if (!x->dead) lobby_enter(s, x);
                 }
-                
-                // Загварт оноо өгөх
-                if (player_count == 5) score += 1000;
-                else if (player_count == 4 && empty_count == 1) score += 100;
-                else if (opponent_count == 4 && empty_count == 1) score += 50;
             }
         }
+        else if (x) lobby_match(s, x, c);
+        else if (c->token) session_resume(s, c);
+        else spectator_join(s, c);
+        c = next;
     }
-    return score;
 }
 
-int check_win(char board[][BOARD_SIZE], int row, int col, char player) {
-    int directions[4][2] = {{0, 1}, {1, 0}, {1, 1}, {-1, 1}};
-    for (int d = 0; d < 4; d++) {
-        int dx = directions[d][0];
-        int dy = directions[d][1];
-        int count = 1;
-        int x = row + dx, y = col + dy;
-        while (x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE && board[x][y] == player) {
-            count++;
-            x += dx;
-            y += dy;
+// wake_fd: ажилчдын хайлт болон шилжиж ирсэн холболтууд
+static void shard_wakeup(Shard *s) {
+    uint64_t count;
+
+    if (read(s->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+        LOG(LOG_ERROR, "eventfd read error: %s\n", strerror(errno));
+    ai_drain(s);
+    arrivals_drain(s);
+}
+
+/*
+ * Холболтын эхний фрейм HELLO байх ёстой: хувилбар, самбарын хэмжээ, ялах
+ * урт, туг. 0 утга нь анхдагч утгыг хэлнэ, HELLO_UNBOUNDED тугтай бол
+ * хязгааргүй самбар (BOARD_SPARSE). Тохирвол WELCOME илгээж лоббид
+ * оруулна: хүлээх болсон эсвэл хүлээгчийн shard руу шилжсэн бол 1.
+ * HELLO_VS_AI тугтай бол лоббигүйгээр AI-тай тоглоом үүсгэнэ. HELLO_SPECTATE,
+ * HELLO_RESUME тугтай бол тоглоомын shard руу шилжиж үзэгч болно эсвэл
+ * суудалдаа буцна (өөр shard бол 1)
+ */
+static int conn_handshake(Conn *c) {
+    Shard *s = c->shard;
+    char type;
+    const char *payload;
+    size_t len;
+    char *buf;
+    size_t avail = rio_peekb(&c->rio, &buf);
+    ssize_t n = frame_parse(buf, avail, &type, &payload, &len);
+
+    if (n == 0) return 0;
+    if (n < 0 || type != MSG_HELLO || len < HELLO_MSG_SIZE) {
+        conn_reject(c, "expected HELLO");
+        return 0;
+    }
+    // Шинэ хувилбарын клиент илүү талбар нэмж болох тул урт нь доод хязгаар
+    uint32_t version = get_u32(payload);
+    int size = (int)get_u32(payload + 4), win_len = (int)get_u32(payload + 8);
+    uint32_t flags = get_u32(payload + 12);
+    if (version >= 1 && (flags & (HELLO_SPECTATE | HELLO_RESUME))) {
+        // Тоглоом нь аль shard дээр байгааг дугаараас нь мэднэ
+        uint32_t id = 0;
+        if (flags & HELLO_RESUME) {
+            if (len < HELLO_RESUME_SIZE) {
+                conn_reject(c, "session expired");
+                return 0;
+            }
+            c->token = (uint64_t)get_u32(payload + HELLO_TOKEN) << 32 | get_u32(payload + HELLO_TOKEN + 4);
+            c->last_seq = get_u32(payload + HELLO_LAST_SEQ);
+            id = c->token >> 32;
+        } else {
+            id = len >= HELLO_GAME + 4 ? get_u32(payload + HELLO_GAME) : 0;
+            if (!id) id = __atomic_load_n(&featured_game, __ATOMIC_RELAXED);
+        }
+        if (!id || (int)(id >> 24) >= nshards) {
+            conn_reject(c, c->token ? "session expired" : "no such game");
+            return 0;
+        }
+        Shard *target = &shards[id >> 24];
+        c->watch = id;
+        rio_consumeb(&c->rio, n);
+        timer_cancel(&s->timers, &c->idle_timer);
+        if (target == s) {
+            if (c->token) session_resume(s, c);
+            else spectator_join(s, c);
+            return 0;
+        }
+        conn_release(s, c);
+        c->next_spec = __atomic_load_n(&target->arrivals, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&target->arrivals, &c->next_spec, c, 0,
+                                            __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+        shard_wake(target);
+        return 1;
+    }
+    if ((flags & HELLO_UNBOUNDED) && (flags & HELLO_VS_AI)) {
+        conn_reject(c, "AI plays on bounded boards only");
+        return 0;
+    }
+    if (flags & HELLO_UNBOUNDED) size = 0;
+    else if (!size) size = DEFAULT_BOARD_SIZE;
+    if (!win_len) win_len = DEFAULT_WIN_LENGTH;
+    // AI-ийн thread-ийг тоглоом бүрээр сонгоно, ажилчдын тоогоор хязгаарлагдана
+    int threads = len >= HELLO_AI_THREADS + 4 ? (int)get_u32(payload + HELLO_AI_THREADS) : 0;
+    if (threads <= 0) threads = ai_threads;
+    if (threads > ai_workers) threads = ai_workers;
+
+    char reason[80];
+    if (version < 1) {
+        conn_reject(c, "unsupported protocol version");
+        return 0;
+    }
+    if (size && (size < MIN_BOARD_SIZE || size > MAX_BOARD_SIZE)) {
+        sprintf(reason, "board size must be between %d and %d", MIN_BOARD_SIZE, MAX_BOARD_SIZE);
+        conn_reject(c, reason);
+        return 0;
+    }
+    if (win_len < MIN_WIN_LENGTH || win_len > MAX_WIN_LENGTH || (size && win_len > size)) {
+        sprintf(reason, "win length must be between %d and %d and fit the board",
+                MIN_WIN_LENGTH, MAX_WIN_LENGTH);
+        conn_reject(c, reason);
+        return 0;
+    }
+    c->board_size = size;
+    c->win_len = win_len;
+    c->ai_threads = threads;
+    rio_consumeb(&c->rio, n);
+
+    // Лоббид хүлээх холболт гаралтын дараалалгүй тул WELCOME-г шууд бичнэ.
+    // Шинэ сокетийн буфер хоосон тул жижиг фрейм бүтнээрээ орно
+    char welcome[FRAME_HDR_SIZE + WELCOME_MSG_SIZE];
+    char *p = frame_init(welcome, MSG_WELCOME, WELCOME_MSG_SIZE);
+    put_u32(p, version < PROTO_VERSION ? version : PROTO_VERSION);
+    put_u32(p + 4, size);
+    put_u32(p + 8, win_len);
+    if (write(c->fd, welcome, sizeof(welcome)) != sizeof(welcome)) {
+        conn_error(c, "write");
+        return 0;
+    }
+
+    timer_cancel(&s->timers, &c->idle_timer);
+    if (flags & HELLO_VS_AI) {
+        // Хүлээх шаардлагагүй: энэ shard дээр шууд AI-тай тоглоно
+        Game *g = game_create(s, c, NULL);
+        LOG(LOG_INFO, "Game %u started on shard %d against AI (%d threads)\n", g->watch_id, s->id, threads);
+        return 0;
+    }
+    return lobby_enter(s, c);
+}
+
+// Клиентээс ирсэн бүрэн фреймүүдийг rio буферээс хуулахгүйгээр боловсруулах:
+// MSG_PLAY row col - хөдөлгөөн, MSG_RESYNC - бүтэн самбар дахин илгээх хүсэлт,
+// MSG_HINT - хүчит ялалтын зөвлөгөө.
+// Дутуу фрейм үлдсэн хэсгээ иртэл буферт үлдэнэ. Холболт лоббид шилжсэн бол 1
+static int conn_process_input(Conn *c) {
+    Game *g = c->game;
+
+    // Лоббид хүлээж байхад дараагийн фреймийг HELLO гэж уншихгүй
+    if (!g) return c->lobby_key || (!c->closing && conn_handshake(c));
+
+    while (!g->game_over && !c->dead) {
+        char type;
+        const char *payload;
+        size_t len;
+        char *buf;
+        size_t avail = rio_peekb(&c->rio, &buf);
+        ssize_t n = frame_parse(buf, avail, &type, &payload, &len);
+        if (n == 0) break;
+        // Үзэгч зөвхөн бүтэн самбар дахин хүсч болно
+        if (n < 0 || (type == MSG_PLAY && len != 8) ||
+            (type != MSG_PLAY && type != MSG_RESYNC && type != MSG_HINT) ||
+            (c->seat < 0 && type != MSG_RESYNC)) {
+            conn_fail(c);
+            break;
         }
-        x = row - dx;
-        y = col - dy;
-        while (x >= 0 && x < BOARD_SIZE && y >= 0 && y < BOARD_SIZE && board[x][y] == player) {
-            count++;
-            x -= dx;
-            y -= dy;
+        if (type == MSG_RESYNC) {
+            rio_consumeb(&c->rio, n);
+            if (c->seat < 0) spectator_send(c, game_snapshot(g));
+            else send_board(c, g);
+            continue;
+        }
+        if (type == MSG_HINT) {
+            rio_consumeb(&c->rio, n);
+            game_hint(g, c);
+            continue;
         }
-        if (count >= 5) return 1;  // Зөвхөн 5 дараалсан
+        // Хөдөлгөөнийг ээлж нь ирэх хүртэл буферт үлдээнэ
+        if (g->current_player != c->seat) break;
+        int row = (int)get_u32(payload), col = (int)get_u32(payload + 4);
+        rio_consumeb(&c->rio, n);
+        game_handle_move(g, row, col);
     }
     return 0;
 }
 
-void send_board(int connfd, char board[][BOARD_SIZE], PlayerStats *stats) {
-    char msg_type = 'B';
-    Rio_writen(connfd, &msg_type, 1);
-    Rio_writen(connfd, board, BOARD_SIZE * BOARD_SIZE);
-    
-    // XO самбарыг хэвлэх
-    printf("\nCurrent Board State (Move #%d):\n", stats[0].moves_made + stats[1].moves_made);
-    printf("Scores - X: %d, O: %d\n", stats[0].score, stats[1].score);
-    printf("  ");
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        printf("%2d ", i);
+static void conn_handle_read(Conn *c) {
+    for (;;) {
+        long t = now_ns();
+        ssize_t n = rio_fillb_nb(&c->rio);
+        // Тоглогчийн уншилт л хөдөлгөөний үе шат
+        if (n > 0 && c->game && c->seat >= 0) phase_mark(c->shard, PHASE_READ, t);
+        if (n == 0) {
+            conn_fail(c);
+            return;
+        }
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) conn_error(c, "read");
+            return;
+        }
+        if (c->closing) {
+            rio_consumeb(&c->rio, c->rio.rio_cnt);
+            continue;
+        }
+        if (conn_process_input(c)) return;
+        if (c->rio.rio_cnt > INBUF_LIMIT) {
+            // Ээлж нь биш үед хэт их өгөгдөл илгээсэн
+            conn_fail(c);
+            return;
+        }
     }
-    printf("\n");
-    
-    for (int i = 0; i < BOARD_SIZE; i++) {
-        printf("%2d ", i);
-        for (int j = 0; j < BOARD_SIZE; j++) {
-            if (board[i][j] == 'X') {
-                printf(ANSI_COLOR_RED " X " ANSI_COLOR_RESET);
-            } else if (board[i][j] == 'O') {
-                printf(ANSI_COLOR_BLUE " O " ANSI_COLOR_RESET);
-            } else {
-                printf(" . ");
-            }
+}
+
+static void conn_close(Conn *c) {
+    Shard *s = c->shard;
+    Game *g = c->game;
+
+    epoll_ctl(s->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    STAT_DEC(s, conns_active);
+    timer_cancel(&s->timers, &c->idle_timer);
+
+    if (g && c->seat < 0) {
+        spectator_unlink(g, c);
+    } else if (g) {
+        g->players[c->seat] = NULL;
+        if (!g->game_over) {
+            // Суудлыг хадгалж, token-оор буцаж орохыг хүлээнэ. Ээлжийн хугацаа үргэлжилнэ
+            LOG(LOG_INFO, "Player %c disconnected, holding the seat for %d s\n",
+                c->seat ? 'O' : 'X', RESUME_GRACE_MS / 1000);
+            timer_add(&s->timers, &g->away_timers[c->seat], now_ms() + RESUME_GRACE_MS,
+                      c->seat ? game_away_o : game_away_x);
         }
-        printf("\n");
+        game_release(g);
     }
-    printf("\n");
+    outq_clear(&c->outq);
+    Free(c);
+}
+
+static void reap_dead_conns(Shard *s) {
+    while (s->dead_conns) {
+        Conn *c = s->dead_conns;
+        s->dead_conns = c->next_dead;
+        conn_close(c);
+    }
+}
+
+// Лоббид хүлээж байхдаа холболт тасарсан эсэхийг шалгах
+static int conn_alive(Conn *c) {
+    char b;
+    ssize_t n = recv(c->fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
 }
 
-int validate_move(char board[][BOARD_SIZE], int row, int col, char *error_msg) {
-    if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE) {
-        sprintf(error_msg, "Position (%d,%d) is out of bounds!", row, col);
+/*
+ * lobby_enter - Лоббид оруулах. Хүлээгч нь өөрийн shard-ийн epoll-д зөвхөн
+ *     тасралтыг ажиглан үлдэх тул тоглоом хүлээгчийн shard дээр үүснэ:
+ *     өөр shard бол c-г arrivals-аар тийш шилжүүлнэ. c хүлээгч болсон
+ *     эсвэл шилжсэн бол 1 (цааш уншихгүй)
+ */
+static int lobby_enter(Shard *s, Conn *c) {
+    uint32_t key = lobby_key(c->board_size, c->win_len, 0);
+    Conn *x;
+
+    c->lobby_since_us = now_us();
+    if (lobby_pair(key, c, (void **)&x) < 0) {
+        // Лобби дүүрсэн: зөвхөн энэ клиентэд татгалзана
+        conn_reject(c, "lobby full, try again later");
         return 0;
     }
-    if (board[row][col] != ' ') {
-        sprintf(error_msg, "Position (%d,%d) is already occupied!", row, col);
+    if (!x) {
+        c->lobby_key = key;
+        conn_watch(c, EPOLLRDHUP);
+        return 1;
+    }
+    Shard *t = x->shard;
+    if (t == s) {
+        lobby_match(s, x, c);
         return 0;
     }
+    conn_release(s, c);
+    c->partner = x;
+    c->next_spec = __atomic_load_n(&t->arrivals, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&t->arrivals, &c->next_spec, c, 0,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+    shard_wake(t);
     return 1;
 }
 
-int main(int argc, char **argv) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <port>\n", argv[0]);
-        exit(0);
+// Хоёулаа s-д бүртгэлтэй. Хүлээгч x хосоо ирэхээс өмнө тасарсан бол c дахин хүлээнэ
+static void lobby_match(Shard *s, Conn *x, Conn *c) {
+    x->lobby_key = 0;
+    if (x->hung || !conn_alive(x)) {
+        if (x->hung) conn_drop(x);
+        else conn_fail(x);
+        lobby_enter(s, c);
+        return;
     }
+    conn_watch(x, EPOLLIN);
+    // Эхэлж хүлээсэн нь X, дараагийнх нь O
+    long waited = now_us() - x->lobby_since_us;
+    STAT_INC(s, pairs);
+    STAT_ADD(s, pair_wait_us, waited);
+    Game *g = game_create(s, x, c);
+    LOG(LOG_INFO, "Game %u started on shard %d (X waited %ld us)\n", g->watch_id, s->id, waited);
+}
 
-    int listenfd = Open_listenfd(argv[1]);
-    printf("Server listening on port %s\n", argv[1]);
-
-    int connfd1 = Accept(listenfd, NULL, NULL);
-    printf("Client 1 connected. Assigned X.\n");
-    Rio_writen(connfd1, "X", 1);
+// Хүлээгч тасарсан: бакетаас гаргаж хаана. Хэн нэгэн аль хэдийн авч, энэ
+// shard руу илгээж байгаа бол тэр ирэх хүртэл хадгална
+static void lobby_hangup(Conn *c) {
+    if (lobby_leave(c->lobby_key, c)) {
+        c->lobby_key = 0;
+        conn_fail(c);
+        return;
+    }
+    c->hung = 1;
+    conn_release(c->shard, c);
+}
 
-    int connfd2 = Accept(listenfd, NULL, NULL);
-    printf("Client 2 connected. Assigned O.\n");
-    Rio_writen(connfd2, "O", 1);
+// HELLO хугацаандаа ирээгүй
+static void conn_idle_timeout(Timer *t) {
+    conn_fail(timer_entry(t, Conn, idle_timer));
+}
 
-    char board[BOARD_SIZE][BOARD_SIZE];
-    memset(board, ' ', BOARD_SIZE * BOARD_SIZE);
- 
-    PlayerStats stats[2] = {{0, 0, 0}, {0, 0, 0}};
-    int current_player = 0;
-    int game_over = 0;
-    int winner = -1;
-    char error_msg[100];
-    int move_analysis[2] = {0, 0};  // Тоглогч бүрийн хөдөлгөөний чанар
-
-    while (!game_over) {
-        send_board(connfd1, board, stats);
-        send_board(connfd2, board, stats);
-
-        int connfd_current = current_player ? connfd2 : connfd1;
-        char turn_msg = 'T';
-        Rio_writen(connfd_current, &turn_msg, 1);
-
-        // Хөдөлгөөний хугацааг эхлүүлэх
-        stats[current_player].last_move_time = time(NULL);
-
-        int row_net, col_net;
-        Rio_readn(connfd_current, &row_net, sizeof(row_net));
-        Rio_readn(connfd_current, &col_net, sizeof(col_net));
-        int row = ntohl(row_net);
-        int col = ntohl(col_net);
-
-        // Хугацааны шалгалт
-        time_t current_time = time(NULL);
-        if (current_time - stats[current_player].last_move_time > MOVE_TIMEOUT) {
-            printf("Player %c timed out!\n", current_player ? 'O' : 'X');
-            winner = !current_player;  // Бусад тоглогч хугацааны дагуу ялна
-            game_over = 1;
-            stats[!current_player].score += 1;
-            break;
+static void accept_conns(Shard *s) {
+    for (;;) {
+        int connfd = accept(s->listenfd, NULL, NULL);
+        if (connfd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                LOG(LOG_ERROR, "accept error: %s\n", strerror(errno));
+            return;
+        }
+        if (set_nonblocking(connfd) < 0) {
+            close(connfd);
+            continue;
         }
+        // Жижиг фреймүүдийг Nagle-ээр саатуулахгүй
+        int one = 1;
+        setsockopt(connfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
 
-        MoveValidationResult validation_result = validate_move_enhanced(board, row, col, error_msg);
-        if (validation_result != MOVE_VALID) {
-            fprintf(stderr, "Invalid move: %s\n", error_msg);
-            printf("Player %c made an invalid move at (%d,%d), please try again\n", 
-                   current_player ? 'O' : 'X', row, col);
+        // HELLO ирэх хүртэл энэ shard дээр хүлээнэ
+        Conn *c = Calloc(1, sizeof(Conn));
+        c->fd = connfd;
+        rio_readinitb(&c->rio, connfd);
+        STAT_INC(s, conns_accepted);
+        if (conn_adopt(s, c) < 0) {
+            conn_drop(c);
             continue;
         }
+        timer_add(&s->timers, &c->idle_timer, now_ms() + HANDSHAKE_TIMEOUT_MS, conn_idle_timeout);
+    }
+}
 
-        // Хөдөлгөөнийг хийхээс өмнө шинжлэх
-        int move_score = analyze_position(board, row, col, current_player ? 'O' : 'X');
-        move_analysis[current_player] += move_score;
-        
-        // Хөдөлгөөнийг хийх
-        board[row][col] = current_player ? 'O' : 'X';
-        stats[current_player].moves_made++;
-
-        printf("Player %c made a move at position (%d, %d) with score %d\n", 
-               current_player ? 'O' : 'X', row, col, move_score);
-
-        if (check_win_enhanced(board, row, col, board[row][col])) {
-            winner = current_player;
-            game_over = 1;
-            stats[current_player].score += 1;
-            printf("Player %c wins!\n", current_player ? 'O' : 'X');
-        } else {
-            int is_draw = 1;
-            for (int i = 0; i < BOARD_SIZE; i++)
-                for (int j = 0; j < BOARD_SIZE; j++)
-                    if (board[i][j] == ' ') is_draw = 0;
-            if (is_draw) {
-                game_over = 1;
-                printf("Game ended in a draw!\n");
+static void *shard_run(void *vargp) {
+    Shard *s = vargp;
+    struct epoll_event events[MAX_EVENTS];
+
+    while (1) {
+        // Дараагийн таймер хүртэл л хүлээнэ
+        int n = epoll_wait(s->epfd, events, MAX_EVENTS, timer_next_timeout(&s->timers));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            unix_error("epoll_wait error");
+        }
+        for (int i = 0; i < n; i++) {
+            Conn *c = events[i].data.ptr;
+            if (!c) {
+                accept_conns(s);
+                continue;
+            }
+            if ((void *)c == s) {
+                shard_wakeup(s);
+                continue;
+            }
+            if (c->dead || c->hung) continue;
+            if (c->lobby_key) {
+                if (events[i].events & (EPOLLRDHUP | EPOLLERR | EPOLLHUP)) lobby_hangup(c);
+                continue;
             }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if ((errno = err)) conn_error(c, "socket");
+                else conn_fail(c);
+                continue;
+            }
+            if (events[i].events & EPOLLOUT) conn_flush(c);
+            if (!c->dead && (events[i].events & EPOLLIN)) conn_handle_read(c);
+        }
+        timer_advance(&s->timers, now_ms());
+        // Энэ tick-д хуримтлагдсан гаралтыг клиент бүрт нэг writev-ээр
+        while (s->dirty_conns || s->dead_conns) {
+            flush_dirty_conns(s);
+            reap_dead_conns(s);
         }
+    }
+    return NULL;
+}
+
+static void shard_init(Shard *s, int id, char *port) {
+    s->id = id;
+    timer_wheel_init(&s->timers, now_ms());
+    for (int i = 0; i < PHASE_COUNT; i++)
+        hist_init(&s->phases[i]);
+    hist_init(&s->game_bytes);
+    // Олон shard нэг портыг SO_REUSEPORT-оор хуваалцаж, kernel холболтуудыг тараана
+    s->listenfd = nshards > 1 ? Open_listenfd_reuseport(port) : Open_listenfd(port);
+    if (set_nonblocking(s->listenfd) < 0)
+        unix_error("fcntl error");
 
-        if (game_over) {
-            char game_over_msg = 'G';
-            int winner_net = htonl(winner);
-            Rio_writen(connfd1, &game_over_msg, 1);
-            Rio_writen(connfd1, &winner_net, sizeof(winner_net));
-            Rio_writen(connfd2, &game_over_msg, 1);
-            Rio_writen(connfd2, &winner_net, sizeof(winner_net));
+    if ((s->epfd = epoll_create1(0)) < 0)
+        unix_error("epoll_create1 error");
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;  // NULL нь сонсох сокет
+    if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, s->listenfd, &ev) < 0)
+        unix_error("epoll_ctl error");
+
+    if ((s->wake_fd = eventfd(0, EFD_NONBLOCK)) < 0)
+        unix_error("eventfd error");
+    ev.data.ptr = s;  // Shard өөрөө нь AI-ийн eventfd
+    if (epoll_ctl(s->epfd, EPOLL_CTL_ADD, s->wake_fd, &ev) < 0)
+        unix_error("epoll_ctl error");
+}
+
+// Shard-уудын ачааллын тэнцвэрийг харуулах
+static void print_shard_stats(void) {
+    for (int i = 0; i < nshards; i++) {
+        Shard *s = &shards[i];
+        unsigned long pairs = STAT_READ(s, pairs);
+        LOG(LOG_INFO, "shard %d: conns %lu/%lu, games active %lu started %lu finished %lu, "
+            "moves %lu, avg pairing wait %lu us, conn errors %lu, forfeits %lu, "
+            "AI moves %lu (%lu from book, %lu nodes), hints %lu (%lu knps), spectators %lu (%lu lagged), resumes %lu (%lu snapshots)\n",
+            s->id, STAT_READ(s, conns_active), STAT_READ(s, conns_accepted),
+            STAT_READ(s, games_active), STAT_READ(s, games_started),
+            STAT_READ(s, games_finished), STAT_READ(s, moves),
+            pairs ? STAT_READ(s, pair_wait_us) / pairs : 0,
+            STAT_READ(s, conn_errors), STAT_READ(s, forfeits),
+            STAT_READ(s, ai_moves), STAT_READ(s, ai_book), STAT_READ(s, ai_nodes), STAT_READ(s, hints),
+            STAT_READ(s, hint_us) ? STAT_READ(s, hint_nodes) * 1000 / STAT_READ(s, hint_us) : 0,
+            STAT_READ(s, spectators), STAT_READ(s, spectator_lags),
+            STAT_READ(s, resumes), STAT_READ(s, resume_snapshots));
+    }
+}
+
+static const char *phase_names[PHASE_COUNT] = {"read", "validate", "analyze", "win_check", "broadcast"};
+// Секундээр: 1 us-ээс 1 s хүртэл 1-2.5-5 алхамтай
+static const double phase_bounds[] = {
+    1e-6, 2.5e-6, 5e-6, 1e-5, 2.5e-5, 5e-5, 1e-4, 2.5e-4, 5e-4,
+    1e-3, 2.5e-3, 5e-3, 1e-2, 2.5e-2, 5e-2, 0.1, 0.25, 0.5, 1
+};
+static const double game_bytes_bounds[] = {
+    256, 512, 1024, 2048, 4096, 8192, 16384, 32768, 65536, 131072, 262144, 524288, 1048576
+};
+
+#define METRIC_COUNTER(m, name, help, field) \
+    (metrics_family(m, name, "counter", help), metrics_value(m, name, NULL, STAT_SUM(field)))
+#define METRIC_GAUGE(m, name, help, v) \
+    (metrics_family(m, name, "gauge", help), metrics_value(m, name, NULL, v))
+
+// Metrics thread дээр scrape бүрт: shard-уудын тоолуур, гистограмыг энд л нэгтгэнэ
+static void render_metrics(MetricsBuf *m) {
+    static long last_us;
+    static unsigned long last_moves;
+    static Hist merged;
+
+    long now = now_us();
+    unsigned long moves = STAT_SUM(moves);
+    double rate = last_us && now > last_us ? (moves - last_moves) * 1e6 / (now - last_us) : 0;
+    last_us = now;
+    last_moves = moves;
+
+    METRIC_GAUGE(m, "xo_connections_active", "Connected clients, including players waiting for a match",
+                 (long)STAT_SUM(conns_active));
+    METRIC_COUNTER(m, "xo_connections_accepted_total", "Accepted connections", conns_accepted);
+    METRIC_COUNTER(m, "xo_connection_errors_total", "Connections closed by socket errors", conn_errors);
+    METRIC_GAUGE(m, "xo_games_active", "Games in progress", (long)STAT_SUM(games_active));
+    METRIC_COUNTER(m, "xo_games_started_total", "Games started", games_started);
+    METRIC_COUNTER(m, "xo_games_finished_total", "Games finished", games_finished);
+    METRIC_COUNTER(m, "xo_moves_total", "Valid moves played, including game-ending ones", moves);
+    METRIC_GAUGE(m, "xo_moves_per_second", "Move rate since the previous scrape", rate);
+    METRIC_COUNTER(m, "xo_invalid_moves_total", "Rejected moves", invalid_moves);
+    METRIC_COUNTER(m, "xo_timeouts_total", "Games lost on the turn clock", timeouts);
+    METRIC_COUNTER(m, "xo_forfeits_total", "Games lost by not coming back after a disconnect", forfeits);
+    METRIC_COUNTER(m, "xo_ai_moves_total", "Moves played by the server AI", ai_moves);
+    METRIC_COUNTER(m, "xo_ai_book_moves_total", "AI moves taken from the opening book", ai_book);
+    METRIC_COUNTER(m, "xo_hints_total", "Hints answered", hints);
+    METRIC_GAUGE(m, "xo_spectators", "Connected spectators", (long)STAT_SUM(spectators));
+    METRIC_COUNTER(m, "xo_resumes_total", "Players that resumed a dropped session", resumes);
+    METRIC_COUNTER(m, "xo_bytes_sent_total", "Bytes written to clients", bytes_sent);
+
+    metrics_family(m, "xo_move_phase_seconds", "histogram", "Move processing latency by phase");
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        char labels[32];
+        hist_init(&merged);
+        for (int i = 0; i < nshards; i++)
+            hist_merge(&merged, &shards[i].phases[p]);
+        snprintf(labels, sizeof(labels), "phase=\"%s\"", phase_names[p]);
+        metrics_histogram(m, "xo_move_phase_seconds", labels, &merged, 1e9, phase_bounds,
+                          sizeof(phase_bounds) / sizeof(phase_bounds[0]));
+    }
+
+    hist_init(&merged);
+    for (int i = 0; i < nshards; i++)
+        hist_merge(&merged, &shards[i].game_bytes);
+    metrics_family(m, "xo_game_bytes_sent", "histogram", "Bytes sent to the players and spectators of each finished game");
+    metrics_histogram(m, "xo_game_bytes_sent", NULL, &merged, 1, game_bytes_bounds,
+                      sizeof(game_bytes_bounds) / sizeof(game_bytes_bounds[0]));
+}
+
+int main(int argc, char **argv) {
+    int opt;
+    LogLevel level = LOG_INFO;
+    char *book_path = NULL, *journal_path = NULL, *metrics_host = NULL, *metrics_port = NULL;
+    while ((opt = getopt(argc, argv, "t:e:l:a:b:j:m:p:o:J:M:")) != -1) {
+        switch (opt) {
+        case 't':
+            nshards = atoi(optarg);
+            break;
+        case 'e':
+            if (board_engine_parse(optarg, &board_engine) < 0)
+                nshards = 0;
+            break;
+        case 'l':
+            if (log_level_parse(optarg, &level) < 0)
+                nshards = 0;
+            break;
+        case 'a':
+            if ((ai_workers = atoi(optarg)) < 1)
+                nshards = 0;
+            break;
+        case 'b':
+            if ((ai_budget_ms = atoi(optarg)) < 1)
+                nshards = 0;
+            break;
+        case 'j':
+            if ((ai_threads = atoi(optarg)) < 1)
+                nshards = 0;
+            break;
+        case 'm':
+            if ((mcts_min_size = atoi(optarg)) < 1)
+                nshards = 0;
+            break;
+        case 'p':
+            if ((mcts_rate = atoi(optarg)) < 0)
+                nshards = 0;
+            break;
+        case 'o':
+            book_path = optarg;
+            break;
+        case 'J':
+            journal_path = optarg;
+            break;
+        case 'M':
+            // [host:]port; host-гүй бол зөвхөн loopback
+            metrics_port = strrchr(optarg, ':');
+            if (metrics_port) {
+                *metrics_port++ = '\0';
+                metrics_host = optarg;
+            } else
+                metrics_port = optarg;
+            break;
+        default:
+            nshards = 0;
         }
+    }
+    if (optind != argc - 1 || nshards < 1) {
+        fprintf(stderr, "Usage: %s [-t threads] [-e dense|bitboard|sparse] "
+                "[-l debug|info|warn|error] [-a ai_workers] [-b ai_budget_ms] [-j ai_threads_per_game] "
+                "[-m mcts_min_size] [-p playouts_per_sec_per_core] [-o opening_book] "
+                "[-J journal] [-M [metrics_host:]metrics_port] <port>\n", argv[0]);
+        exit(0);
+    }
+    char *port = argv[optind];
 
-        current_player = !current_player;
+    // Тасарсан сокет руу бичихэд SIGPIPE биш EPIPE авч, зөвхөн тэр холболтыг хаана
+    Signal(SIGPIPE, SIG_IGN);
+    log_init(level);
+    lobby_init();
+    pattern_init();
+    ai_init(ai_workers);
+    if (book_path) {
+        if (book_open(&book, book_path) < 0) {
+            fprintf(stderr, "%s: not an opening book\n", book_path);
+            exit(1);
+        }
+        LOG(LOG_INFO, "Opening book %s: %u positions\n", book_path, book.hdr->count);
+    }
+    if (journal_path) {
+        journal_open(journal_path);
+        LOG(LOG_INFO, "Journaling games to %s\n", journal_path);
     }
+    shards = Calloc(nshards, sizeof(Shard));
+    for (int i = 0; i < nshards; i++)
+        shard_init(&shards[i], i, port);
+    LOG(LOG_INFO, "Server listening on port %s with %d reactor thread(s)\n", port, nshards);
 
-    // эцсийн тоглоомын статистик
-    printf("\nGame Statistics:\n");
-    printf("Player X: %d moves, Score: %d, Move Quality: %d\n", 
-           stats[0].moves_made, stats[0].score, move_analysis[0]);
-    printf("Player O: %d moves, Score: %d, Move Quality: %d\n", 
-           stats[1].moves_made, stats[1].score, move_analysis[1]);
-    
-    // Хөдөлгөөний чанарын харьцуулалт
-    if (move_analysis[0] > move_analysis[1]) {
-        printf("Player X played more strategically (higher move quality)\n");
-    } else if (move_analysis[1] > move_analysis[0]) {
-        printf("Player O played more strategically (higher move quality)\n");
-    } else {
-        printf("Both players showed similar strategic play\n");
+    for (int i = 0; i < nshards; i++)
+        Pthread_create(&shards[i].tid, NULL, shard_run, &shards[i]);
+    if (metrics_port) {
+        metrics_start(metrics_host, metrics_port, render_metrics);
+        LOG(LOG_INFO, "Serving metrics on http://%s:%s/metrics\n",
+            metrics_host ? metrics_host : METRICS_HOST, metrics_port);
     }
 
-    Close(connfd1);
-    Close(connfd2);
-    Close(listenfd);
+    unsigned long last_moves = 0, last_conns = 0;
+    while (1) {
+        Sleep(STATS_INTERVAL);
+        unsigned long moves = 0, conns = 0;
+        for (int i = 0; i < nshards; i++) {
+            moves += STAT_READ(&shards[i], moves);
+            conns += STAT_READ(&shards[i], conns_accepted);
+        }
+        // Идэвхгүй үед хэвлэхгүй
+        if (moves != last_moves || conns != last_conns)
+            print_shard_stats();
+        last_moves = moves;
+        last_conns = conns;
+    }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,59 @@
+/*
+ * sparse.c - Эзлэгдсэн нүднүүдийн hash (хязгааргүй самбар)
+ */
+#include "csapp.h"
+#include "sparse.h"
+#include <stdint.h>
+
+static unsigned sparse_hash(int row, int col, int cap) {
+    uint64_t key = (uint64_t)(uint32_t)row << 32 | (uint32_t)col;
+    return (unsigned)((key * 0x9E3779B97F4A7C15ULL) >> 32) & (cap - 1);
+}
+
+// (row, col)-ийн слот эсвэл түүнийг оруулах хоосон слот
+static SparseCell *sparse_slot(const SparseMap *m, int row, int col) {
+    unsigned i = sparse_hash(row, col, m->cap);
+
+    while (m->slots[i].stone && (m->slots[i].row != row || m->slots[i].col != col))
+        i = (i + 1) & (m->cap - 1);
+    return &m->slots[i];
+}
+
+void sparse_init(SparseMap *m) {
+    m->cap = SPARSE_MIN_CAP;
+    m->count = 0;
+    m->slots = Calloc(m->cap, sizeof(SparseCell));
+}
+
+void sparse_free(SparseMap *m) {
+    Free(m->slots);
+    m->slots = NULL;
+}
+
+char sparse_get(const SparseMap *m, int row, int col) {
+    SparseCell *s = sparse_slot(m, row, col);
+    return s->stone ? s->stone : ' ';
+}
+
+void sparse_put(SparseMap *m, int row, int col, char stone) {
+    // Дүүргэлт 1/2-оос хэтэрвэл хоёр дахин томсгоно
+    if (2 * (m->count + 1) > m->cap) {
+        SparseMap old = *m;
+        m->cap *= 2;
+        m->slots = Calloc(m->cap, sizeof(SparseCell));
+        for (int i = sparse_next(&old, 0); i >= 0; i = sparse_next(&old, i + 1))
+            *sparse_slot(m, old.slots[i].row, old.slots[i].col) = old.slots[i];
+        Free(old.slots);
+    }
+    SparseCell *s = sparse_slot(m, row, col);
+    if (!s->stone) m->count++;
+    s->row = row;
+    s->col = col;
+    s->stone = stone;
+}
+
+int sparse_next(const SparseMap *m, int i) {
+    for (; i < m->cap; i++)
+        if (m->slots[i].stone) return i;
+    return -1;
+}
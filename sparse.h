@@ -0,0 +1,34 @@
+/*
+ * sparse.h - Эзлэгдсэн нүднүүдийн hash (хязгааргүй самбар)
+ *
+ * (мөр, багана)-ыг чулуутай нь open addressing-ээр хадгална. Санах ой
+ * самбарын талбайгаар биш, тавигдсан чулууны тоогоор өснө.
+ */
+#ifndef __SPARSE_H__
+#define __SPARSE_H__
+
+#define SPARSE_MIN_CAP 64      // 2-ын зэрэг
+
+typedef struct {
+    int row, col;
+    char stone;                // 0 = хоосон слот
+} SparseCell;
+
+typedef struct {
+    SparseCell *slots;
+    int cap;                   // 2-ын зэрэг, хагасаас илүү дүүрэхгүй
+    int count;
+} SparseMap;
+
+void sparse_init(SparseMap *m);
+void sparse_free(SparseMap *m);
+char sparse_get(const SparseMap *m, int row, int col);
+void sparse_put(SparseMap *m, int row, int col, char stone);
+
+/*
+ * sparse_next - i-р слотоос эхлэн дараагийн эзлэгдсэн слотын индекс,
+ *     байхгүй бол -1. for (i = sparse_next(m, 0); i >= 0; i = sparse_next(m, i + 1))
+ */
+int sparse_next(const SparseMap *m, int i);
+
+#endif /* __SPARSE_H__ */
@@ -0,0 +1,106 @@
+/*
+ * timer.c - Shard бүрийн шаталсан timer wheel (миллисекунд)
+ */
+#include "timer.h"
+
+#define TIMER_MASK (TIMER_SLOTS - 1)
+#define TIMER_SPAN(level) (1ULL << (TIMER_BITS * (level)))
+
+void timer_wheel_init(TimerWheel *w, uint64_t now) {
+    w->now = now;
+    w->count = 0;
+    for (int l = 0; l < TIMER_LEVELS; l++)
+        for (int i = 0; i < TIMER_SLOTS; i++)
+            w->slots[l][i].next = w->slots[l][i].prev = &w->slots[l][i];
+}
+
+// Хугацаанаас хамааран түвшин, слотыг сонгож холбох. Хугацаа нь өнгөрсөн
+// таймер earliest слотод орно: шинээр нэмэхэд дараагийн мс, доош шилжүүлэхэд
+// дөнгөж боловсруулах гэж буй одоогийн мс
+static void timer_link(TimerWheel *w, Timer *t, uint64_t earliest) {
+    uint64_t at = t->expires > earliest ? t->expires : earliest;
+    uint64_t delta = at - w->now;
+    int level = 0;
+
+    while (level < TIMER_LEVELS - 1 && delta >= TIMER_SPAN(level + 1))
+        level++;
+    // Хамгийн дээд түвшнээс хол бол тэнд хүлээж, доош шилжихдээ дахин байрлана
+    if (delta >= TIMER_SPAN(TIMER_LEVELS))
+        at = w->now + TIMER_SPAN(TIMER_LEVELS) - 1;
+
+    Timer *head = &w->slots[level][(at >> (TIMER_BITS * level)) & TIMER_MASK];
+    t->next = head;
+    t->prev = head->prev;
+    head->prev->next = t;
+    head->prev = t;
+}
+
+static void timer_unlink(Timer *t) {
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+}
+
+int timer_pending(Timer *t) {
+    return t->next != NULL;
+}
+
+void timer_add(TimerWheel *w, Timer *t, uint64_t expires, void (*fn)(Timer *)) {
+    if (timer_pending(t)) timer_cancel(w, t);
+    t->expires = expires;
+    t->fn = fn;
+    timer_link(w, t, w->now + 1);
+    w->count++;
+}
+
+void timer_cancel(TimerWheel *w, Timer *t) {
+    if (!timer_pending(t)) return;
+    timer_unlink(t);
+    w->count--;
+}
+
+// level түвшний одоогийн слотын таймеруудыг доод түвшинд дахин байрлуулах
+static void timer_cascade(TimerWheel *w, int level) {
+    Timer *head = &w->slots[level][(w->now >> (TIMER_BITS * level)) & TIMER_MASK];
+    Timer *t = head->next;
+
+    head->next = head->prev = head;
+    while (t != head) {
+        Timer *next = t->next;
+        timer_link(w, t, w->now);
+        t = next;
+    }
+}
+
+void timer_advance(TimerWheel *w, uint64_t now) {
+    if (!w->count) {
+        if (now > w->now) w->now = now;
+        return;
+    }
+    while (w->now < now) {
+        w->now++;
+        for (int l = 1; l < TIMER_LEVELS && !(w->now & (TIMER_SPAN(l) - 1)); l++)
+            timer_cascade(w, l);
+
+        Timer *head = &w->slots[0][w->now & TIMER_MASK];
+        while (head->next != head) {
+            Timer *t = head->next;
+            timer_unlink(t);
+            w->count--;
+            t->fn(t);
+        }
+        if (!w->count) {
+            w->now = now;
+            return;
+        }
+    }
+}
+
+int timer_next_timeout(TimerWheel *w) {
+    if (!w->count) return -1;
+    // 0-р түвшний дараагийн таймер эсвэл дээд түвшнээс шилжих хүртэл
+    for (uint64_t t = w->now + 1; ; t++) {
+        if (w->slots[0][t & TIMER_MASK].next != &w->slots[0][t & TIMER_MASK] || !(t & TIMER_MASK))
+            return (int)(t - w->now);
+    }
+}
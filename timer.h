@@ -0,0 +1,51 @@
+/*
+ * timer.h - Shard бүрийн шаталсан timer wheel (миллисекунд)
+ *
+ * TIMER_LEVELS түвшин, тус бүр TIMER_SLOTS слоттой. Ойрын таймер 0-р
+ * түвшинд миллисекунд бүрийн слотод, холынх дээд түвшинд том слотод
+ * байрлаж, доод түвшин эргэх бүрт доош шилжинэ. Нэмэх, цуцлах O(1).
+ * Зөвхөн эзэмшигч thread ашиглана.
+ */
+#ifndef __TIMER_H__
+#define __TIMER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TIMER_BITS 6
+#define TIMER_SLOTS (1 << TIMER_BITS)
+#define TIMER_LEVELS 4                  // 2^24 мс буюу ~4.6 цаг хүртэл шууд
+
+typedef struct Timer {
+    struct Timer *next, *prev;          // Слотын хоёр холбоост жагсаалт
+    uint64_t expires;                   // Мс, wheel-ийн цагаар
+    void (*fn)(struct Timer *t);
+} Timer;
+
+typedef struct {
+    uint64_t now;                       // Сүүлд боловсруулсан мс
+    int count;                          // Идэвхтэй таймерын тоо
+    Timer slots[TIMER_LEVELS][TIMER_SLOTS];  // Жагсаалтын толгойнууд
+} TimerWheel;
+
+// Таймерыг агуулж буй бүтцийг авах
+#define timer_entry(t, type, member) ((type *)((char *)(t) - offsetof(type, member)))
+
+void timer_wheel_init(TimerWheel *w, uint64_t now);
+void timer_add(TimerWheel *w, Timer *t, uint64_t expires, void (*fn)(Timer *));
+void timer_cancel(TimerWheel *w, Timer *t);
+int timer_pending(Timer *t);
+
+/*
+ * timer_advance - now хүртэлх хугацаа нь болсон таймеруудын fn-ийг
+ *     дуудна. fn дотроос таймер нэмэх, цуцлах болно.
+ */
+void timer_advance(TimerWheel *w, uint64_t now);
+
+/*
+ * timer_next_timeout - Дараагийн timer_advance хийх хүртэлх мс (epoll_wait-ийн
+ *     timeout), таймер байхгүй бол -1.
+ */
+int timer_next_timeout(TimerWheel *w);
+
+#endif /* __TIMER_H__ */
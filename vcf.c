@@ -0,0 +1,238 @@
+/*
+ * vcf.c - Дараалсан дөрвөөр хүчээр ялах (VCF) хайлт
+ */
+#include "csapp.h"
+#include "vcf.h"
+#include <stdint.h>
+#include <time.h>
+
+// Нэг шугамын (row, col)-ийг дайрсан хүчинтэй хэсэг
+typedef struct {
+    int dir;                    // 0 мөр, 1 багана, 2 диагональ, 3 эсрэг диагональ
+    int id;                     // Тэр чиглэлийн шугамын дугаар
+    int pos;                    // (row, col)-ийн бит
+    int lo, hi;                 // Самбар дээр байгаа битүүд
+} LineRef;
+
+typedef struct {
+    Board *b;
+    int n;
+    char att, def;              // Довтлогч, хамгаалагч
+    int *stones;                // Довтлогчийн чулуунууд, хайлтынх нь сүүлд
+    int nstones;
+    uint32_t *mark;             // Нүдний давхардлыг хасах
+    uint32_t stamp;
+    unsigned long nodes, budget;
+    int exhausted;
+    int first, length;
+} Vcf;
+
+static int max_int(int a, int b) { return a > b ? a : b; }
+static int min_int(int a, int b) { return a < b ? a : b; }
+
+static long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+static void line_ref(Board *b, int dir, int row, int col, LineRef *l) {
+    int n = b->size, k = row - col, s = row + col;
+
+    l->dir = dir;
+    switch (dir) {
+    case 0:
+        l->id = row;
+        l->pos = col;
+        l->lo = 0;
+        l->hi = n - 1;
+        break;
+    case 1:
+        l->id = col;
+        l->pos = row;
+        l->lo = 0;
+        l->hi = n - 1;
+        break;
+    case 2:
+        l->id = k + n - 1;
+        l->pos = row;
+        l->lo = max_int(0, k);
+        l->hi = min_int(n - 1, n - 1 + k);
+        break;
+    default:
+        l->id = s;
+        l->pos = row;
+        l->lo = max_int(0, s - n + 1);
+        l->hi = min_int(n - 1, s);
+    }
+}
+
+static const uint64_t *plane_line(Board *b, char player, LineRef *l) {
+    BitPlane *bp = &b->bits[player == 'O'];
+    uint64_t *base = l->dir == 0 ? bp->rows : l->dir == 1 ? bp->cols : l->dir == 2 ? bp->diags : bp->antis;
+    return base + l->id * b->words;
+}
+
+// Шугамын бит -> row * n + col
+static int line_cell(Board *b, LineRef *l, int bit) {
+    int n = b->size;
+
+    switch (l->dir) {
+    case 0:  return l->id * n + bit;
+    case 1:  return bit * n + l->id;
+    case 2:  return bit * n + bit - (l->id - n + 1);
+    default: return bit * n + l->id - bit;
+    }
+}
+
+/*
+ * (row, col)-ийг агуулсан win_len урт цонхнуудаас player-ийн яг want
+ * чулуутай, өрсөлдөгчийн чулуугүй цонхны хоосон нүднүүдийг out-д нэмэх.
+ * want = win_len - 1 бол ялах нүд, win_len - 2 бол дөрөв үүсгэх нүд.
+ * Энэ дуудлагын stamp-аар давхардлыг хасна. out-ийн шинэ уртыг буцаана
+ */
+static int scan_windows(Vcf *v, char player, int row, int col, int want, int *out, int count, int max) {
+    Board *b = v->b;
+    const int L = b->win_len;
+    char opp = player == 'X' ? 'O' : 'X';
+
+    for (int dir = 0; dir < 4; dir++) {
+        LineRef l;
+        line_ref(b, dir, row, col, &l);
+        int lo = max_int(l.lo, l.pos - (L - 1)), hi = min_int(l.hi, l.pos + (L - 1));
+        int len = hi - lo + 1;
+        if (len < L) continue;
+
+        uint64_t mine = line_bits(plane_line(b, player, &l), lo, len);
+        uint64_t theirs = line_bits(plane_line(b, opp, &l), lo, len);
+        uint64_t window = (1ULL << L) - 1;
+        for (int i = 0; i + L <= len; i++, window <<= 1) {
+            if ((theirs & window) || __builtin_popcountll(mine & window) != want) continue;
+            for (uint64_t empty = window & ~mine; empty; empty &= empty - 1) {
+                int cell = line_cell(b, &l, lo + __builtin_ctzll(empty));
+                if (v->mark[cell] == v->stamp) continue;
+                v->mark[cell] = v->stamp;
+                if (count == max) return count;
+                out[count++] = cell;
+            }
+        }
+    }
+    return count;
+}
+
+// player-ийн (row, col)-ийг дайрсан ялах нүднүүд, хамгийн ихдээ 2
+static int completions(Vcf *v, char player, int row, int col, int *out) {
+    v->stamp++;
+    return scan_windows(v, player, row, col, v->b->win_len - 1, out, 0, 2);
+}
+
+static void vcf_place(Vcf *v, int cell, char player) {
+    board_place(v->b, cell / v->n, cell % v->n, player);
+    if (player == v->att) v->stones[v->nstones++] = cell;
+}
+
+static void vcf_undo(Vcf *v, int cell, char player) {
+    board_undo(v->b, cell / v->n, cell % v->n);
+    if (player == v->att) v->nstones--;
+}
+
+/*
+ * Довтлогчийн ээлж. must >= 0 бол хамгаалагч дөрөвтэй тул довтлогч тэр
+ * нүдийг хаах ёстой (тэр нь өөрөө дөрөв байх ёстой). Хариу бүр хүчит:
+ * хамгаалагчид ганц л хаах нүд үлддэг
+ */
+static int vcf_attack(Vcf *v, int depth, int must) {
+    int cands[VCF_MAX_CANDS], count = 0;
+
+    if (++v->nodes > v->budget) {
+        v->exhausted = 1;
+        return 0;
+    }
+    if (depth >= VCF_MAX_DEPTH) return 0;
+
+    if (must >= 0) {
+        cands[count++] = must;
+    } else {
+        v->stamp++;
+        for (int i = 0; i < v->nstones && count < VCF_MAX_CANDS; i++)
+            count = scan_windows(v, v->att, v->stones[i] / v->n, v->stones[i] % v->n,
+                                 v->b->win_len - 2, cands, count, VCF_MAX_CANDS);
+    }
+
+    for (int i = 0; i < count; i++) {
+        int cell = cands[i], row = cell / v->n, col = cell % v->n;
+        int comp[2], found = 0;
+
+        vcf_place(v, cell, v->att);
+        int nc = board_check_win(v->b, row, col, v->att) ? 2 : completions(v, v->att, row, col, comp);
+        if (nc >= 2) {
+            // Хоёр нүдийг зэрэг хаах боломжгүй
+            found = 1;
+            v->length = depth + 1;
+        } else if (nc == 1) {
+            int block = comp[0], dcomp[2];
+            vcf_place(v, block, v->def);
+            if (!board_check_win(v->b, block / v->n, block % v->n, v->def)) {
+                int nd = completions(v, v->def, block / v->n, block % v->n, dcomp);
+                if (nd < 2) found = vcf_attack(v, depth + 1, nd ? dcomp[0] : -1);
+            }
+            vcf_undo(v, block, v->def);
+        }
+        vcf_undo(v, cell, v->att);
+
+        if (found) {
+            if (!depth) v->first = cell;
+            return 1;
+        }
+        if (v->exhausted) return 0;
+    }
+    return 0;
+}
+
+int vcf_search(Board *b, char player, unsigned long budget, VcfResult *res) {
+    const int n = b->size;
+    long start = now_us();
+    int found = 0;
+    Vcf v;
+
+    memset(&v, 0, sizeof(v));
+    v.b = b;
+    v.n = n;
+    v.att = player;
+    v.def = player == 'X' ? 'O' : 'X';
+    v.budget = budget;
+    v.first = -1;
+    v.stones = Malloc((size_t)n * n * sizeof(int));
+    v.mark = Calloc((size_t)n * n, sizeof(uint32_t));
+
+    for (int cell = 0; cell < n * n; cell++)
+        if (b->cells[cell] == player) v.stones[v.nstones++] = cell;
+
+    // Одоо байгаа дөрвүүд: довтлогчийнх бол шууд ялна, хамгаалагчийнхыг хаах ёстой
+    int wins[1], nw = 0, threats[2], nt = 0;
+    v.stamp++;
+    for (int i = 0; i < v.nstones && !nw; i++)
+        nw = scan_windows(&v, player, v.stones[i] / n, v.stones[i] % n, b->win_len - 1, wins, nw, 1);
+    v.stamp++;
+    for (int cell = 0; cell < n * n && nt < 2; cell++)
+        if (b->cells[cell] == v.def)
+            nt = scan_windows(&v, v.def, cell / n, cell % n, b->win_len - 1, threats, nt, 2);
+
+    if (nw) {
+        found = 1;
+        v.first = wins[0];
+        v.length = 1;
+    } else if (nt < 2) {
+        found = vcf_attack(&v, 0, nt ? threats[0] : -1);
+    }
+
+    res->row = found ? v.first / n : -1;
+    res->col = found ? v.first % n : -1;
+    res->length = found ? v.length : 0;
+    res->nodes = v.nodes;
+    res->exhausted = v.exhausted;
+    res->elapsed_us = now_us() - start;
+    Free(v.stones);
+    Free(v.mark);
+    return found;
+}
@@ -0,0 +1,35 @@
+/*
+ * vcf.h - Дараалсан дөрвөөр хүчээр ялах (VCF) хайлт
+ *
+ * Довтлогч нүүдэл бүрээрээ "дөрөв" (дараагийн нүүдлээр win_len болох
+ * цонх) үүсгэж, хамгаалагчийг тэр ганц нүдийг хаахад албадна. Хаах нүд
+ * хоёр болвол, эсвэл win_len дараалвал ялалт. Хамгаалагчийн хаалт өөрөө
+ * дөрөв болбол довтлогч дараагийн нүүдлээрээ түүнийг хаах ёстой.
+ * Салаалалт нь зөвхөн дөрөв үүсгэх нүднүүд тул alpha-beta-аас хамаагүй
+ * гүн хүчит дарааллыг миллисекундэд олно. Цонхыг шугамын битүүдээс шууд
+ * тоолох тул зөвхөн BOARD_BITBOARD.
+ */
+#ifndef __VCF_H__
+#define __VCF_H__
+
+#include "board.h"
+
+#define VCF_MAX_DEPTH 40        // Довтлогчийн дөрвийн дээд тоо
+#define VCF_MAX_CANDS 256       // Нэг зангилааны дөрөв үүсгэх нүдний дээд тоо
+
+typedef struct {
+    int row, col;               // Эхний нүүдэл, -1 = хүчит ялалт олдсонгүй
+    int length;                 // Довтлогчийн ялах хүртэлх нүүдлийн тоо
+    unsigned long nodes;
+    long elapsed_us;
+    int exhausted;              // Төсөв дууссан тул бүрэн няцаагаагүй
+} VcfResult;
+
+/*
+ * vcf_search - player нүүх ээлжтэй b дээр дараалсан дөрвөөр хүчээр ялах
+ *     эсэхийг хамгийн ихдээ budget зангилаанд шийдэх. Олдвол 1. b нь хайлтын
+ *     дараа анхны төлөвтөө буцна
+ */
+int vcf_search(Board *b, char player, unsigned long budget, VcfResult *res);
+
+#endif /* __VCF_H__ */